@@ -0,0 +1,2312 @@
+// Headless benchmarks for the game core
+#include <stdio.h>
+#include <time.h>
+#include "board.h"
+#include "world.h"
+#include "maths.h"
+#include "pick.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Entries in an array, as an int to compare with int indices
+
+#define COUNT(Array) ((int)(sizeof(Array) / sizeof(*(Array))))
+
+// Types
+
+// Board's cells, bomb plane and HiddenSafe, to put it back to or compare
+// it with
+
+typedef struct {
+    unsigned char* Cells;
+    unsigned long long* Bombs;
+    int HiddenSafe;
+} snapshot;
+
+// Declarations
+
+double GetSeconds();
+void BenchGames(double Duration);
+void BenchFlood();
+void FloodEmptyQueueScan(board* Board, point Start);
+void BenchBoard(int Width, int Height);
+void* AllocateBoard(board* Target, int Width, int Height);
+void BenchGame(int Width, int Height, int Bombs, unsigned long long Seed);
+size_t BombPlaneBytes();
+int CenterEmptyCell();
+snapshot TakeSnapshot();
+void RestoreSnapshot(snapshot* Snapshot);
+int MatchesSnapshot(snapshot* Snapshot);
+void FreeSnapshot(snapshot* Snapshot);
+void BenchNumbers();
+void CalculateNumbersPerTile(board* Board, unsigned char* Numbers);
+void BenchPlacement();
+void PlaceBombsRejection(board* Board, int Bombs);
+int CountBombs(board* Board);
+void BenchSeeds();
+void BenchChunks();
+void BenchWorld();
+void BenchRegions();
+void BenchMove();
+void BenchClicks();
+void CheckWin();
+int CountHiddenSafe(board* Board);
+void BenchScan();
+void BenchKernels();
+void BenchChords();
+void BenchParallel();
+double TimeFlood(snapshot* Start, int Cell);
+void CheckParallel();
+int PickEmptyStarts(board* Board, rng* Random, int* Starts, int Count);
+void BenchBands();
+void CheckBands();
+void GenerateExcluding(int Bombs, unsigned long long Seed, int* Excluded, int ExcludedCount);
+void BenchSlices();
+void CheckSlices();
+void BenchLazy();
+void CheckLazy();
+void BenchOpening();
+void CheckOpening();
+void BenchPick();
+void BenchMaths();
+matrix RandomMatrix(rng* Random, int Kind);
+double InverseError(matrix* M, matrix* Inverse);
+float RandomFloat(rng* Random, float Min, float Max);
+float RayTriangleDistance(v3 Origin, v3 Direction, triangle* Triangle);
+int PickMeshEach(float* Vertices, int TriangleCount, v3 Origin, v3 Direction, pickHit* Hit);
+int PickTileMesh(pickMesh* Rectangle, v3 Origin, v3 Direction, int X, int Y);
+int PickTilePlane(pickMesh* Rectangle, v3 Origin, v3 Direction, int Width, int Height, float Edge);
+double TimeNewGame(jobs* Jobs, int Bombs, double* Numbers);
+void SetUpChord(unsigned char* Start, board* Saved, int Cell);
+double TimeChord(unsigned char* Start, board* Saved, int Cell, int Batched, unsigned char* Result);
+double TimeKernelNumbers(int Kernel, int Repeats);
+double TimeKernelFloods(int Kernel, int Repeats, unsigned char* Start);
+int AnySafeHidden(board* Board);
+
+int ShouldRun(char* Only, char* Name);
+int ShouldCheck(char* Only, char* Name);
+char* Check(int Same);
+
+// Globals
+
+board Board;
+void* BoardMemory;
+rng Random;
+
+// Comparisons that went wrong, for the exit status
+
+int Failures;
+
+// Functions
+
+// Counts a failed comparison, and returns what ends its line
+
+char* Check(int Same) {
+    if(!Same) {
+        ++Failures;
+    }
+    return Same ? "" : " MISMATCH";
+}
+
+double GetSeconds() {
+#ifdef _WIN32
+    LARGE_INTEGER Count, CountsPerSecond;
+    QueryPerformanceCounter(&Count);
+    QueryPerformanceFrequency(&CountsPerSecond);
+    return (double)Count.QuadPart / (double)CountsPerSecond.QuadPart;
+#else
+    struct timespec Time;
+    clock_gettime(CLOCK_MONOTONIC, &Time);
+    return (double)Time.tv_sec + (double)Time.tv_nsec / 1e9;
+#endif
+}
+
+// Replaces Board with an empty one of the given size
+
+void BenchBoard(int Width, int Height) {
+    free(BoardMemory);
+    BoardMemory = AllocateBoard(&Board, Width, Height);
+}
+
+// Makes Target an empty board of the given size, in memory of its own
+// that the caller frees
+
+void* AllocateBoard(board* Target, int Width, int Height) {
+    void* Memory = calloc(1, BoardMemorySize(Width, Height));
+    assert(Memory);
+    BoardInit(Target, Memory, Width, Height);
+    return Memory;
+}
+
+// Replaces Board with a new game whose first pick is already made, so
+// reveals never move a bomb
+
+void BenchGame(int Width, int Height, int Bombs, unsigned long long Seed) {
+    BenchBoard(Width, Height);
+    BoardNewGame(&Board, Bombs, Seed);
+    Board.FirstPick = 0;
+}
+
+// Bytes in Board's bomb plane, its border words included
+
+size_t BombPlaneBytes() {
+    return (size_t)Board.PlaneStride * (Board.Height + 2) * sizeof(*Board.Bombs);
+}
+
+// The empty tile nearest the middle of Board, going along its row
+
+int CenterEmptyCell() {
+    int Cell = BoardCell(&Board, Board.Width / 2, Board.Height / 2);
+    while(CellType(Board.Cells[Cell]) != EMPTY) ++Cell;
+    return Cell;
+}
+
+snapshot TakeSnapshot() {
+    
+    int Cells = BoardCellCount(Board.Width, Board.Height);
+    snapshot Snapshot = {malloc(Cells), malloc(BombPlaneBytes()), Board.HiddenSafe};
+    assert(Snapshot.Cells && Snapshot.Bombs);
+    
+    memcpy(Snapshot.Cells, Board.Cells, Cells);
+    memcpy(Snapshot.Bombs, Board.Bombs, BombPlaneBytes());
+    return Snapshot;
+}
+
+void RestoreSnapshot(snapshot* Snapshot) {
+    memcpy(Board.Cells, Snapshot->Cells, BoardCellCount(Board.Width, Board.Height));
+    memcpy(Board.Bombs, Snapshot->Bombs, BombPlaneBytes());
+    Board.HiddenSafe = Snapshot->HiddenSafe;
+}
+
+int MatchesSnapshot(snapshot* Snapshot) {
+    return memcmp(Board.Cells, Snapshot->Cells, BoardCellCount(Board.Width, Board.Height)) == 0 &&
+        memcmp(Board.Bombs, Snapshot->Bombs, BombPlaneBytes()) == 0 &&
+        Board.HiddenSafe == Snapshot->HiddenSafe;
+}
+
+void FreeSnapshot(snapshot* Snapshot) {
+    free(Snapshot->Cells);
+    free(Snapshot->Bombs);
+}
+
+// Plays random games: every action reveals or flags a random hidden tile
+
+void BenchGames(double Duration) {
+    
+    long long Games = 0;
+    long long Actions = 0;
+    
+    BenchBoard(10, 10);
+    BoardNewGame(&Board, 9, RngNext(&Random));
+    
+    double Start = GetSeconds();
+    double Elapsed = 0.0;
+    
+    while(Elapsed < Duration) {
+        
+        for(int Step = 0; Step < 4096; ++Step) {
+            
+            if(!Board.Playing) {
+                BoardNewGame(&Board, 9, RngNext(&Random));
+                ++Games;
+            }
+            
+            int X = RngBelow(&Random, Board.Width);
+            int Y = RngBelow(&Random, Board.Height);
+            
+            if(Board.Cells[BoardCell(&Board, X, Y)] & CELL_REVEALED) continue;
+            
+            if(RngBelow(&Random, 8) == 0) {
+                BoardFlag(&Board, X, Y);
+            } else {
+                BoardReveal(&Board, X, Y);
+            }
+            ++Actions;
+        }
+        
+        Elapsed = GetSeconds() - Start;
+    }
+    
+    printf("games %dx%d, %d bombs: %lld games (%.0f games/sec), %lld actions (%.0f actions/sec)\n",
+           Board.Width, Board.Height, Board.BombCount,
+           Games, (double)Games / Elapsed,
+           Actions, (double)Actions / Elapsed);
+}
+
+// The flood as it was before the visited bitmap, for comparison.
+// Reached is searched linearly, and only up to its current Length.
+
+typedef struct {
+    point* Items;
+    int First;
+    int Index;
+    int Length;
+} pointQueue;
+
+void PointQueueAdd(pointQueue* Queue, point Position) {
+    ++Queue->Length;
+    Queue->Items[Queue->Index++] = Position;
+}
+
+point PointQueuePop(pointQueue* Queue) {
+    --Queue->Length;
+    return Queue->Items[Queue->First++];
+}
+
+int PointQueueHasItem(pointQueue* Queue, point Position) {
+    for(int Index = 0; Index < Queue->Length; ++Index) {
+        if(Queue->Items[Index].X == Position.X && Queue->Items[Index].Y == Position.Y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void FloodEmptyQueueScan(board* Board, point Start) {
+    
+    pointQueue Frontier = {.Items = malloc(Board->Width * Board->Height * 8 * sizeof(point))};
+    pointQueue Reached = {.Items = malloc(Board->Width * Board->Height * 8 * sizeof(point))};
+    
+    PointQueueAdd(&Frontier, Start);
+    PointQueueAdd(&Reached, Start);
+    
+    RevealNumbersAround(Board, BoardCell(Board, Start.X, Start.Y));
+    
+    while(Frontier.Length > 0) {
+        point Current = PointQueuePop(&Frontier);
+        int Cell = BoardCell(Board, Current.X, Current.Y);
+        
+        for(int Index = 0; Index < 8; ++Index) {
+            int Neighbor = Cell + Board->Offsets[Index];
+            point Position = BoardCellPosition(Board, Neighbor);
+            if(CellType(Board->Cells[Neighbor]) == EMPTY && !PointQueueHasItem(&Reached, Position)) {
+                PointQueueAdd(&Reached, Position);
+                PointQueueAdd(&Frontier, Position);
+                
+                BoardRevealTile(Board, Neighbor);
+                
+                RevealNumbersAround(Board, Neighbor);
+            }
+        }
+    }
+    
+    free(Frontier.Items);
+    free(Reached.Items);
+}
+
+// Opens a square board with no bombs from its center
+
+void BenchFlood() {
+    
+    int Sizes[] = {16, 32, 64, 128, 256, 512, 1000, 4000, 10000};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Size = Sizes[Index];
+        point Center = {Size / 2, Size / 2};
+        
+        BenchBoard(Size, Size);
+        BoardNewGame(&Board, 0, 0);
+        double Start = GetSeconds();
+        FloodEmpty(&Board, BoardCell(&Board, Center.X, Center.Y));
+        double Bitmap = GetSeconds() - Start;
+        
+        // The linear scan is quadratic, skip it where it would take minutes
+        
+        if(Size <= 128) {
+            BoardNewGame(&Board, 0, 0);
+            Start = GetSeconds();
+            FloodEmptyQueueScan(&Board, Center);
+            double Scan = GetSeconds() - Start;
+            
+            printf("flood %5dx%-5d: bitmap %9.3f ms, queue scan %9.3f ms (%.0fx)\n",
+                   Size, Size, Bitmap * 1000.0, Scan * 1000.0, Scan / Bitmap);
+        } else {
+            printf("flood %5dx%-5d: bitmap %9.3f ms, %.1f M tiles/sec, %.1f MB board\n",
+                   Size, Size, Bitmap * 1000.0, (double)Size * Size / Bitmap / 1e6,
+                   BoardMemorySize(Size, Size) / 1e6);
+        }
+    }
+}
+
+// Numbers the way CalculateNumbers used to find them, a tile at a time
+
+void CalculateNumbersPerTile(board* Board, unsigned char* Numbers) {
+    for(int Y = 0; Y < Board->Height; ++Y) {
+        for(int X = 0; X < Board->Width; ++X) {
+            if(BoardGetBit(Board, Board->Bombs, X, Y)) {
+                Numbers[Y * Board->Width + X] = 0;
+            } else {
+                Numbers[Y * Board->Width + X] = BoardCountNeighbors(Board, BoardCell(Board, X, Y), BOMB);
+            }
+        }
+    }
+}
+
+// Counts numbers for boards with a sixth of the tiles being bombs
+
+void BenchNumbers() {
+
+#if defined(BOARD_AVX2)
+    char* Path = "avx2";
+#elif defined(BOARD_SSE2)
+    char* Path = "sse2";
+#else
+    char* Path = "scalar";
+#endif
+    
+    int Sizes[][2] = {{30, 16}, {1000, 1000}, {4000, 4000}, {10000, 10000}, {333, 30000}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Tiles = Width * Height;
+        
+        BenchBoard(Width, Height);
+        BoardNewGame(&Board, Tiles / 6, 1);
+        
+        // Small boards are repeated to get a measurable time
+        
+        int Repeats = 1 + 10000000 / Tiles;
+        double Start = GetSeconds();
+        for(int Repeat = 0; Repeat < Repeats; ++Repeat) {
+            CalculateNumbers(&Board);
+        }
+        double Planes = (GetSeconds() - Start) / Repeats;
+        
+        unsigned char* Numbers = malloc(Tiles);
+        Start = GetSeconds();
+        CalculateNumbersPerTile(&Board, Numbers);
+        double PerTile = GetSeconds() - Start;
+        
+        int Same = 1;
+        for(int Tile = 0; Tile < Tiles; ++Tile) {
+            Same &= Numbers[Tile] == (Board.Cells[BoardCell(&Board, Tile % Width, Tile / Width)] & CELL_COUNT);
+        }
+        free(Numbers);
+        
+        printf("numbers %5dx%-5d: %s %9.3f ms (%.2f GB/s written), per tile %9.3f ms (%.0fx)%s\n",
+               Width, Height, Path, Planes * 1000.0, Tiles / Planes / 1e9,
+               PerTile * 1000.0, PerTile / Planes, Check(Same));
+    }
+}
+
+// Placement as it was before Floyd's sampling: random tiles until enough
+// of them were free
+
+void PlaceBombsRejection(board* Board, int Bombs) {
+    int Placed = 0;
+    while(Placed < Bombs) {
+        int X = rand() % Board->Width;
+        int Y = rand() % Board->Height;
+        if(!BoardGetBit(Board, Board->Bombs, X, Y)) {
+            BoardSetBit(Board, Board->Bombs, X, Y);
+            ++Placed;
+        }
+    }
+}
+
+int CountBombs(board* Board) {
+    int Count = 0;
+    for(int Y = 0; Y < Board->Height; ++Y) {
+        for(int Word = 0; Word < Board->RowWords; ++Word) {
+            Count += CountBits(*BoardPlaneWord(Board, Board->Bombs, Word * 64, Y));
+        }
+    }
+    return Count;
+}
+
+// Places bombs on an empty 1000x1000 board at increasing densities
+
+void BenchPlacement() {
+    
+    int Size = 1000;
+    int Tiles = Size * Size;
+    double Densities[] = {0.01, 0.1, 0.2, 0.5, 0.8, 0.9, 0.99, 0.999};
+    
+    BenchBoard(Size, Size);
+    size_t PlaneBytes = BombPlaneBytes();
+    
+    // Keep the first pick's area free, like a game would
+    
+    int Excluded[9];
+    for(int Index = 0; Index < 9; ++Index) {
+        Excluded[Index] = (Size / 2 - 1 + Index / 3) * Size + Size / 2 - 1 + Index % 3;
+    }
+    
+    for(int Index = 0; Index < COUNT(Densities); ++Index) {
+        
+        int Bombs = (int)(Densities[Index] * Tiles);
+        
+        memset(Board.Bombs, 0, PlaneBytes);
+        double Start = GetSeconds();
+        PlaceBombs(&Board, Bombs, Excluded, 9);
+        double Floyd = GetSeconds() - Start;
+        
+        int Correct = CountBombs(&Board) == Bombs;
+        for(int Tile = 0; Tile < 9; ++Tile) {
+            if(BoardGetBit(&Board, Board.Bombs, Excluded[Tile] % Size, Excluded[Tile] / Size)) {
+                Correct = 0;
+            }
+        }
+        
+        memset(Board.Bombs, 0, PlaneBytes);
+        Start = GetSeconds();
+        PlaceBombsRejection(&Board, Bombs);
+        double Rejection = GetSeconds() - Start;
+        
+        printf("placement %dx%d, %5.1f%% bombs: floyd %8.3f ms, rejection %8.3f ms (%.1fx)%s\n",
+               Size, Size, Densities[Index] * 100.0, Floyd * 1000.0, Rejection * 1000.0,
+               Rejection / Floyd, Check(Correct));
+    }
+}
+
+// Generates expert boards from seeds, and checks that every seed gives
+// the same board again after other boards were made in between
+
+void BenchSeeds() {
+    
+    int Games = 100000;
+    rng Replay = Random;
+    rng Seeds = RngSplit(&Random);
+    
+    BenchBoard(30, 16);
+    size_t PlaneBytes = BombPlaneBytes();
+    unsigned long long* First = malloc(Games / 100 * PlaneBytes);
+    
+    double Start = GetSeconds();
+    for(int Game = 0; Game < Games; ++Game) {
+        BoardNewGame(&Board, 99, RngNext(&Seeds));
+        if(Game % 100 == 0) {
+            memcpy((char*)First + Game / 100 * PlaneBytes, Board.Bombs, PlaneBytes);
+        }
+    }
+    double Elapsed = GetSeconds() - Start;
+    
+    // Replay the same seeds
+    
+    Seeds = RngSplit(&Replay);
+    
+    int Different = 0;
+    for(int Game = 0; Game < Games; ++Game) {
+        unsigned long long Seed = RngNext(&Seeds);
+        if(Game % 100 == 0) {
+            BoardNewGame(&Board, 99, Seed);
+            Different += memcmp((char*)First + Game / 100 * PlaneBytes, Board.Bombs, PlaneBytes) != 0;
+        }
+    }
+    free(First);
+    
+    printf("seeds 30x16, 99 bombs: %d boards (%.0f boards/sec), %d of %d replayed seeds differ%s\n",
+           Games, Games / Elapsed, Different, Games / 100, Check(Different == 0));
+}
+
+// Places a 10000x10000 board's bombs, then remakes random chunks of it on
+// their own and compares. Also generates chunks in the density mode.
+
+void BenchChunks() {
+    
+    int Size = 10000;
+    int Bombs = Size / 10 * Size / 10 * 15;
+    
+    BenchBoard(Size, Size);
+    Board.Seed = 7;
+    
+    double Start = GetSeconds();
+    PlaceBombs(&Board, Bombs, NULL, 0);
+    double Whole = GetSeconds() - Start;
+    
+    int Placed = CountBombs(&Board);
+    
+    int Chunks = 1000;
+    int Different = 0;
+    unsigned long long Saved[CHUNK_SIZE];
+    
+    Start = GetSeconds();
+    for(int Chunk = 0; Chunk < Chunks; ++Chunk) {
+        
+        int ChunkX = RngBelow(&Random, Board.RowWords);
+        int ChunkY = RngBelow(&Random, (Size + CHUNK_SIZE - 1) / CHUNK_SIZE);
+        int Height = Size - ChunkY * CHUNK_SIZE < CHUNK_SIZE ? Size - ChunkY * CHUNK_SIZE : CHUNK_SIZE;
+        
+        for(int Y = 0; Y < Height; ++Y) {
+            unsigned long long* Word = BoardPlaneWord(&Board, Board.Bombs, ChunkX * CHUNK_SIZE, ChunkY * CHUNK_SIZE + Y);
+            Saved[Y] = *Word;
+            *Word = 0;
+        }
+        
+        PlaceChunkBombs(&Board, ChunkX, ChunkY, Bombs, NULL, 0);
+        
+        for(int Y = 0; Y < Height; ++Y) {
+            Different += Saved[Y] != *BoardPlaneWord(&Board, Board.Bombs, ChunkX * CHUNK_SIZE, ChunkY * CHUNK_SIZE + Y);
+        }
+    }
+    double Single = (GetSeconds() - Start) / Chunks;
+    
+    printf("chunks %dx%d, %d bombs: whole board %.1f ms, %d placed, one chunk %.2f us, %d of %d remade chunks differ%s\n",
+           Size, Size, Bombs, Whole * 1000.0, Placed, Single * 1e6, Different, Chunks,
+           Check(Different == 0 && Placed == Bombs));
+    
+    // Density mode, 15% of 2^32
+    
+    unsigned int Density = (unsigned int)(0.15 * 4294967296.0);
+    long long Count = 0;
+    unsigned long long Rows[CHUNK_SIZE];
+    
+    Start = GetSeconds();
+    for(int Chunk = 0; Chunk < Chunks * 10; ++Chunk) {
+        ChunkBombsByDensity(7, Chunk % 100, Chunk / 100, Density, Rows);
+        for(int Y = 0; Y < CHUNK_SIZE; ++Y) {
+            Count += CountBits(Rows[Y]);
+        }
+    }
+    double Dense = (GetSeconds() - Start) / (Chunks * 10);
+    
+    printf("chunks by density 15%%: one chunk %.2f us, %.4f%% bombs over %d chunks\n",
+           Dense * 1e6, 100.0 * Count / ((double)Chunks * 10 * CHUNK_SIZE * CHUNK_SIZE), Chunks * 10);
+}
+
+// Checks a world's numbers against a board built from the same chunks, then
+// floods a world with few bombs, where the empty area never ends
+
+void BenchWorld() {
+    
+    world World = {0};
+    unsigned int Density = (unsigned int)(0.15 * 4294967296.0);
+    
+    WorldNewGame(&World, Density, 3);
+    BenchBoard(4 * CHUNK_SIZE, 4 * CHUNK_SIZE);
+    
+    unsigned long long Rows[CHUNK_SIZE];
+    for(int ChunkY = 0; ChunkY < 4; ++ChunkY) {
+        for(int ChunkX = 0; ChunkX < 4; ++ChunkX) {
+            WorldChunkBombs(&World, ChunkX, ChunkY, Rows);
+            for(int Y = 0; Y < CHUNK_SIZE; ++Y) {
+                *BoardPlaneWord(&Board, Board.Bombs, ChunkX * CHUNK_SIZE, ChunkY * CHUNK_SIZE + Y) = Rows[Y];
+            }
+        }
+    }
+    CalculateNumbers(&Board);
+    
+    // Tiles on the board's edge miss the bombs beyond it
+    
+    int Different = 0;
+    for(int Y = 1; Y < 4 * CHUNK_SIZE - 1; ++Y) {
+        for(int X = 1; X < 4 * CHUNK_SIZE - 1; ++X) {
+            tile Tile = BoardGetTile(&Board, X, Y);
+            Different += Tile.Type != WorldGetType(&World, X, Y) ||
+                Tile.BombsNearAmount != WorldGetTile(&World, X, Y).BombsNearAmount;
+        }
+    }
+    
+    printf("world numbers: %d tiles differ from a board of the same chunks%s\n", Different, Check(Different == 0));
+    
+    // 5% bombs, a flood that would never end without its budget
+    
+    WorldNewGame(&World, (unsigned int)(0.05 * 4294967296.0), 3);
+    
+    double Start = GetSeconds();
+    WorldReveal(&World, 0, 0);
+    int Tiles = 1000000;
+    while(World.RevealedCount < Tiles && WorldFlood(&World, WORLD_FLOOD_BUDGET) > 0);
+    double Elapsed = GetSeconds() - Start;
+    
+    printf("world flood 5%% bombs: %lld tiles in %.1f ms (%.1f M tiles/sec), %d chunks, %.1f MB, %d tiles left waiting\n",
+           World.RevealedCount, Elapsed * 1000.0, World.RevealedCount / Elapsed / 1e6,
+           World.ChunkCount, WorldMemorySize(&World) / 1e6, World.Frontier.Length);
+    
+    WorldFree(&World);
+}
+
+// Opens every empty region of a board once by flooding and once from the
+// region index, and compares what got revealed
+
+void BenchRegions() {
+    
+    int Sizes[] = {30, 1000, 4000};
+    double Densities[] = {0.1, 0.2};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        for(int Density = 0; Density < COUNT(Densities); ++Density) {
+            
+            int Size = Sizes[Index];
+            BenchBoard(Size, Size);
+            BoardNewGame(&Board, (int)(Densities[Density] * Size * Size), 5);
+            
+            double Start = GetSeconds();
+            BoardBuildRegions(&Board);
+            double Build = GetSeconds() - Start;
+            
+            regions* Regions = &Board.Regions;
+            
+            Start = GetSeconds();
+            for(int Region = 0; Region < Regions->Count; ++Region) {
+                FloodEmpty(&Board, Regions->Cells[Regions->CellStarts[Region]]);
+            }
+            double Flood = GetSeconds() - Start;
+            
+            int Cells = BoardCellCount(Size, Size);
+            unsigned char* Flooded = malloc(Cells);
+            memcpy(Flooded, Board.Cells, Cells);
+            for(int Y = 0; Y < Size; ++Y) {
+                for(int X = 0; X < Size; ++X) {
+                    Board.Cells[BoardCell(&Board, X, Y)] &= ~CELL_REVEALED;
+                }
+            }
+            
+            Start = GetSeconds();
+            for(int Region = 0; Region < Regions->Count; ++Region) {
+                BoardRevealRegion(&Board, Region);
+            }
+            double Lookup = GetSeconds() - Start;
+            
+            int Same = memcmp(Flooded, Board.Cells, Cells) == 0;
+            free(Flooded);
+            
+            printf("regions %4dx%-4d %2.0f%% bombs: %7d regions, build %8.3f ms, flood %8.3f ms, index %8.3f ms (%.1fx, %.0f regions/sec)%s\n",
+                   Size, Size, Densities[Density] * 100.0, Regions->Count, Build * 1000.0,
+                   Flood * 1000.0, Lookup * 1000.0, Flood / Lookup, Regions->Count / Lookup,
+                   Check(Same));
+            
+            BoardFreeRegions(&Board);
+        }
+    }
+}
+
+// Moves bombs like a first pick on one does, counting only around the two
+// tiles, and compares with counting the whole board as before
+
+void BenchMove() {
+    
+    int Sizes[] = {30, 1000, 4000, 10000};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Size = Sizes[Index];
+        int Tiles = Size * Size;
+        int Moves = 100;
+        
+        BenchBoard(Size, Size);
+        BoardNewGame(&Board, Tiles / 6, 11);
+        
+        // Distinct bombs to move, found before timing
+        
+        int* Picks = malloc(Moves * sizeof(*Picks));
+        for(int Move = 0; Move < Moves; ++Move) {
+            int Tile;
+            int Taken;
+            do {
+                Tile = RngBelow(&Random, Tiles);
+                Taken = 0;
+                for(int Before = 0; Before < Move; ++Before) {
+                    Taken |= Picks[Before] == Tile;
+                }
+            } while(Taken || !BoardGetBit(&Board, Board.Bombs, Tile % Size, Tile / Size));
+            Picks[Move] = Tile;
+        }
+        
+        double Start = GetSeconds();
+        for(int Move = 0; Move < Moves; ++Move) {
+            MoveBomb(&Board, Picks[Move] % Size, Picks[Move] / Size);
+        }
+        double Incremental = (GetSeconds() - Start) / Moves;
+        free(Picks);
+        
+        int Cells = BoardCellCount(Size, Size);
+        unsigned char* Numbers = malloc(Cells);
+        memcpy(Numbers, Board.Cells, Cells);
+        
+        Start = GetSeconds();
+        CalculateNumbers(&Board);
+        double Whole = GetSeconds() - Start;
+        
+        int Same = memcmp(Numbers, Board.Cells, Cells) == 0;
+        free(Numbers);
+        
+        printf("move %5dx%-5d: move bomb %7.3f us, counting whole board %11.3f us (%.0fx)%s\n",
+               Size, Size, Incremental * 1e6, Whole * 1e6, Whole / Incremental,
+               Check(Same));
+    }
+}
+
+// The win check as it was before HiddenSafe, run after every click
+
+int AnySafeHidden(board* Board) {
+    for(int Cell = 0; Cell < BoardCellCount(Board->Width, Board->Height); ++Cell) {
+        if(!(Board->Cells[Cell] & (CELL_REVEALED | CELL_BOMB))) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Clicks hidden safe tiles on big boards, late in a game when the old win
+// check had to scan furthest before finding a hidden safe tile
+
+void BenchClicks() {
+    
+    int Sizes[] = {30, 1000, 4000};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Size = Sizes[Index];
+        int Clicks = 1000;
+        
+        BenchGame(Size, Size, Size * Size / 5, 13);
+        
+        // Reveal everything but the last row
+        
+        for(int Y = 0; Y < Size - 1; ++Y) {
+            for(int X = 0; X < Size; ++X) {
+                if(!BoardGetBit(&Board, Board.Bombs, X, Y)) {
+                    BoardRevealTile(&Board, BoardCell(&Board, X, Y));
+                }
+            }
+        }
+        
+        double Click = 0.0;
+        double Scan = 0.0;
+        int Done = 0;
+        int Hidden = 0;
+        
+        for(int Try = 0; Try < 100 * Clicks && Done < Clicks && Board.Playing; ++Try) {
+            
+            int X = RngBelow(&Random, Size);
+            int Y = Size - 1;
+            
+            if(Board.Cells[BoardCell(&Board, X, Y)] & (CELL_BOMB | CELL_REVEALED)) continue;
+            
+            double Start = GetSeconds();
+            BoardReveal(&Board, X, Y);
+            Click += GetSeconds() - Start;
+            
+            Start = GetSeconds();
+            Hidden += AnySafeHidden(&Board);
+            Scan += GetSeconds() - Start;
+            
+            ++Done;
+        }
+        
+        printf("clicks %4dx%-4d: %8.3f us per click, the old win check would add %9.3f us (%d of %d clicks left safe tiles hidden)\n",
+               Size, Size, Click / Done * 1e6, Scan / Done * 1e6, Hidden, Done);
+    }
+}
+
+// Hidden tiles without bombs, counted from the cells
+
+int CountHiddenSafe(board* Board) {
+    int Count = 0;
+    for(int Cell = 0; Cell < BoardCellCount(Board->Width, Board->Height); ++Cell) {
+        Count += !(Board->Cells[Cell] & (CELL_REVEALED | CELL_BOMB));
+    }
+    return Count;
+}
+
+// Plays random games of reveals, flags and chords, a third of them with
+// the region index, and checks HiddenSafe against the cells after every
+// action, and that a win leaves no safe tile hidden
+
+void CheckWin() {
+    
+    int Games = 20000;
+    int Width = 20;
+    int Height = 13;
+    int Wrong = 0;
+    int Wins = 0;
+    
+    rng Random;
+    RngSeed(&Random, 3);
+    BenchBoard(Width, Height);
+    
+    for(int Game = 0; Game < Games; ++Game) {
+        
+        BoardNewGame(&Board, 1 + RngBelow(&Random, 40), RngNext(&Random));
+        if(Game % 3 == 0) {
+            BoardBuildRegions(&Board);
+        }
+        
+        while(Board.Playing) {
+            
+            int X = RngBelow(&Random, Width);
+            int Y = RngBelow(&Random, Height);
+            int Action = RngBelow(&Random, 10);
+            
+            if(Action == 0) {
+                BoardFlag(&Board, X, Y);
+            } else if(Action == 1) {
+                BoardChord(&Board, X, Y);
+            } else if(!BoardGetBit(&Board, Board.Bombs, X, Y) || RngBelow(&Random, 20) == 0) {
+                BoardReveal(&Board, X, Y);
+            }
+            
+            if(Board.Playing && CountHiddenSafe(&Board) != Board.HiddenSafe) {
+                ++Wrong;
+                break;
+            }
+        }
+        
+        if(Board.Win) {
+            ++Wins;
+            Wrong += CountHiddenSafe(&Board) != 0;
+        }
+        BoardFreeRegions(&Board);
+    }
+    
+    printf("check win %dx%d: %d games, %d won, %d went wrong%s\n", Width, Height, Games, Wins, Wrong, Check(Wrong == 0));
+}
+
+// Reads every tile of a half opened board the way drawing does, and shows
+// what a board costs per tile
+
+void BenchScan() {
+    
+    int Sizes[] = {30, 1000, 4000, 10000};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Size = Sizes[Index];
+        long long Tiles = (long long)Size * Size;
+        
+        BenchGame(Size, Size, (int)(Tiles / 6), 17);
+        
+        for(int Y = 0; Y < Size; Y += 2) {
+            for(int X = 0; X < Size; ++X) {
+                if(!BoardGetBit(&Board, Board.Bombs, X, Y)) {
+                    BoardRevealTile(&Board, BoardCell(&Board, X, Y));
+                }
+            }
+        }
+        
+        int Repeats = 1 + 10000000 / Tiles;
+        long long Shown = 0;
+        
+        double Start = GetSeconds();
+        for(int Repeat = 0; Repeat < Repeats; ++Repeat) {
+            for(int Y = 0; Y < Size; ++Y) {
+                for(int X = 0; X < Size; ++X) {
+                    tile Tile = BoardGetTile(&Board, X, Y);
+                    Shown += Tile.Visible + Tile.Flagged + Tile.BombsNearAmount;
+                }
+            }
+        }
+        double Elapsed = (GetSeconds() - Start) / Repeats;
+        
+        printf("scan %5dx%-5d: %.1f M tiles/sec (%lld), %.2f bytes per tile\n",
+               Size, Size, Tiles / Elapsed / 1e6, Shown / Repeats,
+               (double)BoardMemorySize(Size, Size) / Tiles);
+    }
+}
+
+// Counts numbers, then opens the board from each of its empty tiles in
+// turn, with the size's own kernels and with the shared ones. The 20x20
+// board has no kernel of its own, for comparison.
+
+void BenchKernels() {
+    
+    int Sizes[][3] = {{9, 9, 10}, {16, 16, 40}, {30, 16, 99}, {20, 20, 60}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Cells = BoardCellCount(Width, Height);
+        int Repeats = 20000;
+        
+        BenchBoard(Width, Height);
+        BoardNewGame(&Board, Sizes[Index][2], 19);
+        int Kernel = Board.Kernel;
+        
+        unsigned char* Start = malloc(Cells);
+        memcpy(Start, Board.Cells, Cells);
+        
+        double Sized = TimeKernelNumbers(Kernel, Repeats);
+        double Generic = TimeKernelNumbers(KERNEL_GENERIC, Repeats);
+        int Same = memcmp(Start, Board.Cells, Cells) == 0;
+        
+        double SizedFloods = TimeKernelFloods(Kernel, Repeats / 10, Start);
+        unsigned char* Flooded = malloc(Cells);
+        memcpy(Flooded, Board.Cells, Cells);
+        double GenericFloods = TimeKernelFloods(KERNEL_GENERIC, Repeats / 10, Start);
+        
+        Same &= memcmp(Flooded, Board.Cells, Cells) == 0;
+        free(Flooded);
+        free(Start);
+        
+        printf("kernels %2dx%-2d%s: numbers %6.1f ns, generic %6.1f ns (%.2fx), floods %7.2f us, generic %7.2f us (%.2fx)%s\n",
+               Width, Height, Kernel == KERNEL_GENERIC ? " (generic)" : "          ",
+               Sized * 1e9, Generic * 1e9, Generic / Sized,
+               SizedFloods * 1e6, GenericFloods * 1e6, GenericFloods / SizedFloods,
+               Check(Same));
+    }
+}
+
+// Seconds per CalculateNumbers of Board with the given kernel, the best of
+// five rounds since the sized and shared ones are close
+
+double TimeKernelNumbers(int Kernel, int Repeats) {
+    
+    int Saved = Board.Kernel;
+    Board.Kernel = Kernel;
+    
+    double Best = 1e9;
+    for(int Round = 0; Round < 5; ++Round) {
+        double Start = GetSeconds();
+        for(int Repeat = 0; Repeat < Repeats; ++Repeat) {
+            CalculateNumbers(&Board);
+        }
+        double Elapsed = (GetSeconds() - Start) / Repeats;
+        Best = Elapsed < Best ? Elapsed : Best;
+    }
+    
+    Board.Kernel = Saved;
+    return Best;
+}
+
+// Seconds to flood Board from every empty tile of Start, each from a fresh
+// copy of it, the best of five rounds. Board is left with the last flood.
+
+double TimeKernelFloods(int Kernel, int Repeats, unsigned char* Start) {
+    
+    int Saved = Board.Kernel;
+    int Cells = BoardCellCount(Board.Width, Board.Height);
+    Board.Kernel = Kernel;
+    
+    double Best = 1e9;
+    for(int Round = 0; Round < 5; ++Round) {
+        double Begin = GetSeconds();
+        for(int Repeat = 0; Repeat < Repeats; ++Repeat) {
+            for(int Cell = 0; Cell < Cells; ++Cell) {
+                if(CellType(Start[Cell]) == EMPTY) {
+                    memcpy(Board.Cells, Start, Cells);
+                    FloodEmpty(&Board, Cell);
+                }
+            }
+        }
+        double Elapsed = (GetSeconds() - Begin) / Repeats;
+        Best = Elapsed < Best ? Elapsed : Best;
+    }
+    
+    Board.Kernel = Saved;
+    return Best;
+}
+
+// Chords every number of a board once, each on a fresh copy with the
+// number revealed and its bombs flagged, against clicking the same hidden
+// neighbors one by one. The two take turns going first, as whichever runs
+// first after the copy is slower.
+
+void BenchChords() {
+    
+    int Sizes[][3] = {{30, 16, 99}, {200, 200, 4000}, {1000, 1000, 100000}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Cells = BoardCellCount(Width, Height);
+        
+        BenchGame(Width, Height, Sizes[Index][2], 23);
+        
+        board Saved = Board;
+        unsigned char* Start = malloc(Cells);
+        unsigned char* Chorded = malloc(Cells);
+        unsigned char* Clicked = malloc(Cells);
+        memcpy(Start, Board.Cells, Cells);
+        
+        double Chord = 0.0;
+        double Clicks = 0.0;
+        int Chords = 0;
+        int Same = 1;
+        
+        for(int Cell = 0; Cell < Cells && Chords < 2000; ++Cell) {
+            
+            if(CellType(Start[Cell]) != NUMBER) continue;
+            
+            if(Chords & 1) {
+                Clicks += TimeChord(Start, &Saved, Cell, 0, Clicked);
+                Chord += TimeChord(Start, &Saved, Cell, 1, Chorded);
+            } else {
+                Chord += TimeChord(Start, &Saved, Cell, 1, Chorded);
+                Clicks += TimeChord(Start, &Saved, Cell, 0, Clicked);
+            }
+            
+            Same &= memcmp(Chorded, Clicked, Cells) == 0;
+            ++Chords;
+        }
+        
+        free(Start);
+        free(Chorded);
+        free(Clicked);
+        
+        printf("chords %4dx%-4d: %d chords, batched %7.3f us, clicking each neighbor %7.3f us (%.2fx)%s\n",
+               Width, Height, Chords, Chord / Chords * 1e6, Clicks / Chords * 1e6, Clicks / Chord,
+               Check(Same));
+    }
+}
+
+// Seconds for one chord of Cell, batched or as one click per hidden
+// neighbor, with the cells it leaves copied to Result
+
+double TimeChord(unsigned char* Start, board* Saved, int Cell, int Batched, unsigned char* Result) {
+    
+    SetUpChord(Start, Saved, Cell);
+    
+    double Begin = GetSeconds();
+    if(Batched) {
+        point Position = BoardCellPosition(&Board, Cell);
+        BoardChord(&Board, Position.X, Position.Y);
+    } else {
+        for(int Neighbor = 0; Neighbor < 8; ++Neighbor) {
+            point Click = BoardCellPosition(&Board, Cell + Board.Offsets[Neighbor]);
+            if(!(Board.Cells[Cell + Board.Offsets[Neighbor]] & CELL_REVEALED)) {
+                BoardReveal(&Board, Click.X, Click.Y);
+            }
+        }
+    }
+    double Elapsed = GetSeconds() - Begin;
+    
+    memcpy(Result, Board.Cells, BoardCellCount(Board.Width, Board.Height));
+    return Elapsed;
+}
+
+// Puts Board back to Start and Saved, with Cell revealed and its bombs
+// flagged
+
+void SetUpChord(unsigned char* Start, board* Saved, int Cell) {
+    
+    memcpy(Board.Cells, Start, BoardCellCount(Board.Width, Board.Height));
+    Board.Playing = Saved->Playing;
+    Board.HiddenSafe = Saved->HiddenSafe;
+    Board.Flags = Saved->Flags;
+    Board.Win = Saved->Win;
+    
+    BoardRevealTile(&Board, Cell);
+    for(int Neighbor = 0; Neighbor < 8; ++Neighbor) {
+        if(CellType(Board.Cells[Cell + Board.Offsets[Neighbor]]) == BOMB) {
+            Board.Cells[Cell + Board.Offsets[Neighbor]] |= CELL_FLAGGED;
+            --Board.Flags;
+        }
+    }
+}
+
+// Opens one large low density area on the calling thread, then on job
+// pools of 1 thread up to the processor count (and at least 4), and checks
+// that every pool reveals the same tiles
+
+void BenchParallel() {
+    
+    int Sizes[][3] = {{2048, 2048, 20000}, {4096, 4096, 80000}, {10000, 10000, 500000}};
+    
+    int Processors = JobsProcessorCount();
+    int MaxThreads = Processors > 4 ? Processors : 4;
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        
+        BenchGame(Width, Height, Sizes[Index][2], 29);
+        int Start = CenterEmptyCell();
+        snapshot Initial = TakeSnapshot();
+        
+        double SerialTime = TimeFlood(&Initial, Start);
+        int Opened = Initial.HiddenSafe - Board.HiddenSafe;
+        snapshot Serial = TakeSnapshot();
+        
+        printf("parallel %5dx%-5d: %d tiles opened, serial %8.2f ms\n", Width, Height, Opened, SerialTime * 1e3);
+        
+        for(int Threads = 1; Threads <= MaxThreads; Threads *= 2) {
+            
+            jobs Jobs;
+            JobsStart(&Jobs, Threads);
+            Board.Jobs = &Jobs;
+            
+            double Time = TimeFlood(&Initial, Start);
+            int Same = MatchesSnapshot(&Serial);
+            
+            Board.Jobs = NULL;
+            JobsStop(&Jobs);
+            
+            printf("parallel %5dx%-5d: %2d threads %8.2f ms (%.2fx)%s\n",
+                   Width, Height, Threads, Time * 1e3, SerialTime / Time, Check(Same));
+        }
+        
+        FreeSnapshot(&Initial);
+        FreeSnapshot(&Serial);
+    }
+    
+    printf("parallel: %d processors\n", Processors);
+}
+
+// Fills Starts with Count random empty tiles of Board, which must have
+// some. Returns Count.
+
+int PickEmptyStarts(board* Board, rng* Random, int* Starts, int Count) {
+    for(int Index = 0; Index < Count;) {
+        int Cell = BoardCell(Board, RngBelow(Random, Board->Width), RngBelow(Random, Board->Height));
+        if(CellType(Board->Cells[Cell]) == EMPTY) {
+            Starts[Index++] = Cell;
+        }
+    }
+    return Count;
+}
+
+// Floods random boards of odd sizes and densities from up to 8 starts at
+// once, serially and on pools of 1 to 5 threads, and compares the cells
+// and HiddenSafe. Boards are over the parallel size, so the pools take
+// the chunked path.
+
+void CheckParallel() {
+    
+    int Runs = 40;
+    int Wrong = 0;
+    
+    rng Random;
+    RngSeed(&Random, 5);
+    
+    for(int Run = 0; Run < Runs; ++Run) {
+        
+        int Width = 1024 + RngBelow(&Random, 300);
+        int Height = 1024 + RngBelow(&Random, 200);
+        
+        BenchGame(Width, Height, Width * Height / 100 * (1 + RngBelow(&Random, 15)), Run);
+        
+        int Starts[8];
+        int Count = PickEmptyStarts(&Board, &Random, Starts, 1 + Run % 8);
+        snapshot Initial = TakeSnapshot();
+        
+        FloodEmptyMany(&Board, Starts, Count);
+        snapshot Serial = TakeSnapshot();
+        
+        jobs Jobs;
+        JobsStart(&Jobs, 1 + Run % 5);
+        Board.Jobs = &Jobs;
+        
+        RestoreSnapshot(&Initial);
+        FloodEmptyMany(&Board, Starts, Count);
+        Wrong += !MatchesSnapshot(&Serial);
+        
+        Board.Jobs = NULL;
+        JobsStop(&Jobs);
+        FreeSnapshot(&Initial);
+        FreeSnapshot(&Serial);
+    }
+    
+    printf("check parallel: %d boards, %d differ from the serial flood%s\n", Runs, Wrong, Check(Wrong == 0));
+}
+
+// Seconds for a flood from Cell on a board put back to Start
+
+double TimeFlood(snapshot* Start, int Cell) {
+    
+    RestoreSnapshot(Start);
+    
+    double Begin = GetSeconds();
+    FloodEmpty(&Board, Cell);
+    return GetSeconds() - Begin;
+}
+
+// Generates large boards, bombs and numbers, on the calling thread and on
+// job pools of 1 thread up to the processor count (and at least 4), and
+// checks that every pool makes the same board
+
+void BenchBands() {
+    
+    int Sizes[][3] = {{4000, 4000, 2400000}, {333, 30000, 1500000}, {10000, 10000, 15000000}};
+    
+    int Processors = JobsProcessorCount();
+    int MaxThreads = Processors > 4 ? Processors : 4;
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        
+        BenchBoard(Width, Height);
+        double SerialNumbers;
+        double Serial = TimeNewGame(NULL, Sizes[Index][2], &SerialNumbers);
+        snapshot SerialBoard = TakeSnapshot();
+        
+        printf("bands %5dx%-5d: serial   new game %8.2f ms, numbers %7.2f ms\n",
+               Width, Height, Serial * 1e3, SerialNumbers * 1e3);
+        
+        for(int Threads = 1; Threads <= MaxThreads; Threads *= 2) {
+            
+            jobs Jobs;
+            JobsStart(&Jobs, Threads);
+            
+            double Numbers;
+            double Time = TimeNewGame(&Jobs, Sizes[Index][2], &Numbers);
+            int Same = MatchesSnapshot(&SerialBoard);
+            
+            JobsStop(&Jobs);
+            
+            printf("bands %5dx%-5d: %2d threads new game %8.2f ms, numbers %7.2f ms (%.2fx, %.2fx)%s\n",
+                   Width, Height, Threads, Time * 1e3, Numbers * 1e3,
+                   Serial / Time, SerialNumbers / Numbers, Check(Same));
+        }
+        
+        FreeSnapshot(&SerialBoard);
+    }
+    
+    printf("bands: %d processors\n", Processors);
+}
+
+// Board made from Seed with the first pick's area free, as it is with a
+// safe opening
+
+void GenerateExcluding(int Bombs, unsigned long long Seed, int* Excluded, int ExcludedCount) {
+    BoardNewGame(&Board, Bombs, Seed);
+    memset(Board.Bombs, 0, BombPlaneBytes());
+    PlaceBombs(&Board, Bombs, Excluded, ExcludedCount);
+    CalculateNumbers(&Board);
+}
+
+// Generates boards of odd sizes with an excluded area, serially and on
+// pools of 2 to 4 threads, and compares the cells and bomb planes
+
+void CheckBands() {
+    
+    int Runs = 6;
+    int Wrong = 0;
+    
+    for(int Run = 0; Run < Runs; ++Run) {
+        
+        int Width = 1030 + Run * 77;
+        int Height = 1025 + Run * 31;
+        int Bombs = Width * Height / (3 + Run);
+        
+        BenchBoard(Width, Height);
+        
+        int Excluded[9];
+        for(int Index = 0; Index < 9; ++Index) {
+            Excluded[Index] = (500 + Index / 3) * Width + 600 + Index % 3;
+        }
+        
+        GenerateExcluding(Bombs, Run, Excluded, 9);
+        snapshot Serial = TakeSnapshot();
+        
+        jobs Jobs;
+        JobsStart(&Jobs, 2 + Run % 3);
+        Board.Jobs = &Jobs;
+        
+        GenerateExcluding(Bombs, Run, Excluded, 9);
+        Wrong += !MatchesSnapshot(&Serial);
+        
+        Board.Jobs = NULL;
+        JobsStop(&Jobs);
+        FreeSnapshot(&Serial);
+    }
+    
+    printf("check bands: %d boards, %d differ from serial generation%s\n", Runs, Wrong, Check(Wrong == 0));
+}
+
+// Seconds for a new game, best of 3, and for counting its numbers again
+// in Numbers, with Jobs as the board's pool
+
+double TimeNewGame(jobs* Jobs, int Bombs, double* Numbers) {
+    
+    Board.Jobs = Jobs;
+    
+    double Best = 1e9;
+    *Numbers = 1e9;
+    
+    for(int Repeat = 0; Repeat < 3; ++Repeat) {
+        
+        double Begin = GetSeconds();
+        BoardNewGame(&Board, Bombs, 31);
+        double Elapsed = GetSeconds() - Begin;
+        Best = Elapsed < Best ? Elapsed : Best;
+        
+        Begin = GetSeconds();
+        CalculateNumbers(&Board);
+        Elapsed = GetSeconds() - Begin;
+        *Numbers = Elapsed < *Numbers ? Elapsed : *Numbers;
+    }
+    
+    Board.Jobs = NULL;
+    return Best;
+}
+
+// Opens a large area in one go, then again a frame's budget at a time as
+// the game does, on the calling thread and on a job pool, and reports the
+// longest frame. Both have to end with the same tiles revealed. The last
+// board's frontier is cut down so it keeps overflowing, which has to stay
+// within the budget too.
+
+void BenchSlices() {
+    
+    int Sizes[][5] = {{1000, 1000, 5000, 0, 0}, {4000, 4000, 80000, 0, 0}, {4000, 4000, 80000, 4, 0}, {4000, 4000, 80000, 0, 1024}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Threads = Sizes[Index][3];
+        
+        jobs Jobs;
+        if(Threads) {
+            JobsStart(&Jobs, Threads);
+        }
+        
+        BenchGame(Width, Height, Sizes[Index][2], 37);
+        Board.Jobs = Threads ? &Jobs : NULL;
+        if(Sizes[Index][4]) {
+            Board.Frontier.Capacity = Sizes[Index][4];
+        }
+        
+        int Start = CenterEmptyCell();
+        snapshot Initial = TakeSnapshot();
+        
+        double WholeTime = TimeFlood(&Initial, Start);
+        snapshot Whole = TakeSnapshot();
+        
+        RestoreSnapshot(&Initial);
+        Board.FloodBudget = BOARD_FLOOD_BUDGET;
+        
+        double Begin = GetSeconds();
+        FloodEmpty(&Board, Start);
+        double Longest = GetSeconds() - Begin;
+        double Total = Longest;
+        int Frames = 1;
+        
+        for(int Unfinished = 1; Unfinished; ++Frames) {
+            Begin = GetSeconds();
+            Unfinished = BoardFlood(&Board, BOARD_FLOOD_BUDGET);
+            double Elapsed = GetSeconds() - Begin;
+            Longest = Elapsed > Longest ? Elapsed : Longest;
+            Total += Elapsed;
+        }
+        
+        int Same = MatchesSnapshot(&Whole);
+        
+        printf("slices %4dx%-4d %d threads%s: %d tiles opened, whole %7.2f ms, %3d frames of %d tiles, longest %5.2f ms, total %7.2f ms%s\n",
+               Width, Height, Threads, Sizes[Index][4] ? ", small frontier" : "", Initial.HiddenSafe - Board.HiddenSafe, WholeTime * 1e3,
+               Frames, BOARD_FLOOD_BUDGET, Longest * 1e3, Total * 1e3, Check(Same));
+        
+        Board.FloodBudget = 0;
+        Board.Jobs = NULL;
+        if(Threads) {
+            JobsStop(&Jobs);
+        }
+        FreeSnapshot(&Initial);
+        FreeSnapshot(&Whole);
+    }
+}
+
+// Floods random boards a random budget at a time, with two more starts
+// clicked in the middle of it, and compares with one unbudgeted flood from
+// all four. Small boards take the array frontier, the others the ring, cut
+// down on some of them so it overflows, or a job pool on the others.
+
+void CheckSlices() {
+    
+    int Runs = 30;
+    int Wrong = 0;
+    
+    rng Random;
+    RngSeed(&Random, 9);
+    
+    for(int Run = 0; Run < Runs; ++Run) {
+        
+        int Small = Run % 3 == 0;
+        int Width = Small ? 20 + RngBelow(&Random, 60) : 1024 + RngBelow(&Random, 300);
+        int Height = Small ? 20 + RngBelow(&Random, 60) : 1024 + RngBelow(&Random, 200);
+        
+        BenchGame(Width, Height, Width * Height / 100 * (1 + RngBelow(&Random, 12)), Run);
+        
+        int Starts[4];
+        PickEmptyStarts(&Board, &Random, Starts, 4);
+        snapshot Initial = TakeSnapshot();
+        
+        FloodEmptyMany(&Board, Starts, 4);
+        snapshot Whole = TakeSnapshot();
+        
+        jobs Jobs;
+        JobsStart(&Jobs, 1 + Run % 4);
+        
+        for(int Variant = 0; Variant < 2; ++Variant) {
+            
+            if(Variant && !Small) {
+                if(Run % 3 == 1) {
+                    Board.Frontier.Capacity = 64 + RngBelow(&Random, 1024);
+                    Board.Frontier.First = 0;
+                } else {
+                    Board.Jobs = &Jobs;
+                }
+            }
+            
+            RestoreSnapshot(&Initial);
+            Board.FloodBudget = 1 + RngBelow(&Random, 5000);
+            
+            FloodEmptyMany(&Board, Starts, 2);
+            int Frames = 0;
+            while(BoardFlood(&Board, 1 + RngBelow(&Random, 20000))) {
+                if(Frames++ == 2) {
+                    FloodEmptyMany(&Board, Starts + 2, 2);
+                }
+            }
+            if(Frames <= 2) {
+                FloodEmptyMany(&Board, Starts + 2, 2);
+            }
+            while(BoardFlood(&Board, 7000));
+            
+            Wrong += !MatchesSnapshot(&Whole) || BoardFlooding(&Board);
+        }
+        
+        Board.FloodBudget = 0;
+        Board.Jobs = NULL;
+        JobsStop(&Jobs);
+        FreeSnapshot(&Initial);
+        FreeSnapshot(&Whole);
+    }
+    
+    printf("check slices: %d boards, %d budgeted floods differ from a whole one%s\n", Runs, Wrong, Check(Wrong == 0));
+}
+
+// New games with and without lazy numbers, next to placing the bombs
+// alone, then what a lazy board pays later: the first frame of a click in
+// the middle and reading a screen of tiles elsewhere
+
+void BenchLazy() {
+    
+    int Sizes[][3] = {{4000, 4000, 800000}, {10000, 10000, 5000000}, {10000, 10000, 15000000}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Bombs = Sizes[Index][2];
+        
+        BenchBoard(Width, Height);
+        size_t PlaneBytes = BombPlaneBytes();
+        
+        double Eager = 1e9;
+        double Lazy = 1e9;
+        double Placement = 1e9;
+        
+        for(int Repeat = 0; Repeat < 3; ++Repeat) {
+            
+            Board.LazyNumbers = 0;
+            double Begin = GetSeconds();
+            BoardNewGame(&Board, Bombs, 41);
+            double Elapsed = GetSeconds() - Begin;
+            Eager = Elapsed < Eager ? Elapsed : Eager;
+            
+            memset(Board.Bombs, 0, PlaneBytes);
+            Begin = GetSeconds();
+            PlaceBombs(&Board, Bombs, NULL, 0);
+            Elapsed = GetSeconds() - Begin;
+            Placement = Elapsed < Placement ? Elapsed : Placement;
+            
+            Board.LazyNumbers = 1;
+            Begin = GetSeconds();
+            BoardNewGame(&Board, Bombs, 41);
+            Elapsed = GetSeconds() - Begin;
+            Lazy = Elapsed < Lazy ? Elapsed : Lazy;
+        }
+        
+        // The click gets one frame's flood budget, as in the game
+        
+        Board.FloodBudget = BOARD_FLOOD_BUDGET;
+        double Begin = GetSeconds();
+        BoardReveal(&Board, Width / 2, Height / 2);
+        double Click = GetSeconds() - Begin;
+        int Opened = Width * Height - Bombs - Board.HiddenSafe;
+        BoardStopFlood(&Board);
+        Board.FloodBudget = 0;
+        
+        Begin = GetSeconds();
+        for(int Y = Height / 4; Y < Height / 4 + 60; ++Y) {
+            for(int X = Width / 4; X < Width / 4 + 100; ++X) {
+                BoardGetTile(&Board, X, Y);
+            }
+        }
+        double Screen = GetSeconds() - Begin;
+        
+        printf("lazy %5dx%-5d: new game %7.2f ms, lazy %7.2f ms (%.1fx), placing bombs alone %7.2f ms, "
+               "then first click %6.3f ms (%d tiles in its frame), 100x60 screen %6.3f ms\n",
+               Width, Height, Eager * 1e3, Lazy * 1e3, Eager / Lazy, Placement * 1e3,
+               Click * 1e3, Opened, Screen * 1e3);
+        
+        Board.LazyNumbers = 0;
+    }
+}
+
+// Plays random games on an eager and a lazy board of the same seed in
+// lockstep, mostly small boards and some over the parallel size, half of
+// those flooding on a job pool a budget at a time. Compares random tiles,
+// the game state and, at the end, every cell once the lazy board is
+// counted whole.
+
+void CheckLazy() {
+    
+    int Games = 300;
+    int Wrong = 0;
+    board Eager;
+    board Lazy;
+    
+    rng Random;
+    RngSeed(&Random, 11);
+    
+    jobs Jobs;
+    JobsStart(&Jobs, 3);
+    
+    for(int Game = 0; Game < Games; ++Game) {
+        
+        int Large = Game % 25 == 0;
+        int Width = Large ? 1100 + RngBelow(&Random, 200) : 5 + RngBelow(&Random, 150);
+        int Height = Large ? 1030 + RngBelow(&Random, 100) : 5 + RngBelow(&Random, 150);
+        int Bombs = (int)((long long)Width * Height * (1 + RngBelow(&Random, 25)) / 100);
+        
+        void* EagerMemory = AllocateBoard(&Eager, Width, Height);
+        void* LazyMemory = AllocateBoard(&Lazy, Width, Height);
+        Lazy.LazyNumbers = 1;
+        if(Large && Game % 2) {
+            Lazy.Jobs = &Jobs;
+            Lazy.FloodBudget = 20000;
+        }
+        
+        BoardNewGame(&Eager, Bombs, Game);
+        BoardNewGame(&Lazy, Bombs, Game);
+        
+        for(int Step = 0; Step < 400 && Eager.Playing; ++Step) {
+            
+            int X = RngBelow(&Random, Width);
+            int Y = RngBelow(&Random, Height);
+            int Action = RngBelow(&Random, 10);
+            
+            if(Action < 6) {
+                BoardReveal(&Eager, X, Y);
+                BoardReveal(&Lazy, X, Y);
+            } else if(Action < 8) {
+                BoardFlag(&Eager, X, Y);
+                BoardFlag(&Lazy, X, Y);
+            } else {
+                BoardChord(&Eager, X, Y);
+                BoardChord(&Lazy, X, Y);
+            }
+            while(BoardFlood(&Lazy, 30000));
+            
+            int Different = Eager.Playing != Lazy.Playing || Eager.Win != Lazy.Win || Eager.Flags != Lazy.Flags ||
+                (Eager.Playing && Eager.HiddenSafe != Lazy.HiddenSafe);
+            
+            for(int Sample = 0; Sample < 20 && !Different; ++Sample) {
+                X = RngBelow(&Random, Width);
+                Y = RngBelow(&Random, Height);
+                tile A = BoardGetTile(&Eager, X, Y);
+                tile B = BoardGetTile(&Lazy, X, Y);
+                Different = memcmp(&A, &B, sizeof(A)) != 0;
+            }
+            
+            if(Different) {
+                ++Wrong;
+                break;
+            }
+        }
+        
+        Lazy.LazyNumbers = 0;
+        CalculateNumbers(&Lazy);
+        Wrong += memcmp(Eager.Cells, Lazy.Cells, BoardCellCount(Width, Height)) != 0;
+        
+        BoardStopFlood(&Lazy);
+        free(EagerMemory);
+        free(LazyMemory);
+    }
+    
+    JobsStop(&Jobs);
+    printf("check lazy: %d games, %d went differently from an eager board%s\n", Games, Wrong, Check(Wrong == 0));
+}
+
+// New games and their first click at a random tile, with the bombs placed
+// by the new game and one moved away from under the click, and with them
+// placed at the click around a safe opening. Counts the first clicks that
+// open an area.
+
+void BenchOpening() {
+    
+    int Sizes[][4] = {{9, 9, 10, 100000}, {16, 16, 40, 100000}, {30, 16, 99, 100000}, {10000, 10000, 15000000, 3}};
+    
+    for(int Index = 0; Index < COUNT(Sizes); ++Index) {
+        
+        int Width = Sizes[Index][0];
+        int Height = Sizes[Index][1];
+        int Games = Sizes[Index][3];
+        
+        BenchBoard(Width, Height);
+        Board.LazyNumbers = Width * Height >= PARALLEL_TILES;
+        
+        double Time[2];
+        int Opened[2];
+        
+        for(int Safe = 0; Safe < 2; ++Safe) {
+            
+            rng Clicks;
+            RngSeed(&Clicks, 43);
+            Board.SafeOpening = Safe;
+            Board.FloodBudget = BOARD_FLOOD_BUDGET;
+            Opened[Safe] = 0;
+            
+            double Begin = GetSeconds();
+            for(int Game = 0; Game < Games; ++Game) {
+                BoardNewGame(&Board, Sizes[Index][2], Game);
+                BoardReveal(&Board, RngBelow(&Clicks, Width), RngBelow(&Clicks, Height));
+                Opened[Safe] += Width * Height - Sizes[Index][2] - Board.HiddenSafe > 1 || BoardFlooding(&Board);
+            }
+            Time[Safe] = (GetSeconds() - Begin) / Games;
+        }
+        
+        printf("opening %5dx%-5d %8d bombs: moved bomb %9.3f us, %5.1f%% open an area; safe opening %9.3f us, %5.1f%% open an area\n",
+               Width, Height, Sizes[Index][2], Time[0] * 1e6, 100.0 * Opened[0] / Games,
+               Time[1] * 1e6, 100.0 * Opened[1] / Games);
+        
+        Board.SafeOpening = 0;
+        Board.LazyNumbers = 0;
+        Board.FloodBudget = 0;
+        BoardStopFlood(&Board);
+    }
+}
+
+// Plays the first click of random safe opening games, on boards from
+// nearly empty to nearly full, eager and lazy side by side, every 200th
+// over the parallel size. Checks that the bombs are all placed and none
+// under the click or, when they fit, around it, that the click opened an
+// area and kept the flag put down before it, that the numbers match a
+// recount, and that the lazy board ends up the same.
+
+void CheckOpening() {
+    
+    int Games = 2000;
+    int Wrong = 0;
+    board Eager;
+    board Lazy;
+    
+    rng Random;
+    RngSeed(&Random, 12);
+    
+    jobs Jobs;
+    JobsStart(&Jobs, 2);
+    
+    for(int Game = 0; Game < Games; ++Game) {
+        
+        int Large = Game % 200 == 0;
+        int Width = Large ? 1100 : 2 + RngBelow(&Random, 40);
+        int Height = Large ? 1000 : 2 + RngBelow(&Random, 40);
+        int Tiles = Width * Height;
+        int Cells = BoardCellCount(Width, Height);
+        int Bombs = Game % 7 == 0 ? Tiles - 1 - (int)RngBelow(&Random, 3) : (int)((long long)Tiles * RngBelow(&Random, 30) / 100);
+        Bombs = Bombs < 0 ? 0 : Bombs;
+        
+        void* EagerMemory = AllocateBoard(&Eager, Width, Height);
+        void* LazyMemory = AllocateBoard(&Lazy, Width, Height);
+        unsigned char* Counted = malloc(Cells);
+        assert(Counted);
+        Eager.SafeOpening = 1;
+        Lazy.SafeOpening = 1;
+        Lazy.LazyNumbers = 1;
+        Lazy.Jobs = Large ? &Jobs : NULL;
+        
+        BoardNewGame(&Eager, Bombs, Game);
+        BoardNewGame(&Lazy, Bombs, Game);
+        
+        // A flag before the click, and a tile drawn on the lazy board
+        
+        int X = RngBelow(&Random, Width);
+        int Y = RngBelow(&Random, Height);
+        int FlagX = RngBelow(&Random, Width);
+        int FlagY = RngBelow(&Random, Height);
+        int Flagged = FlagX != X || FlagY != Y;
+        if(Flagged) {
+            BoardFlag(&Eager, FlagX, FlagY);
+            BoardFlag(&Lazy, FlagX, FlagY);
+        }
+        BoardGetTile(&Lazy, RngBelow(&Random, Width), RngBelow(&Random, Height));
+        
+        BoardReveal(&Eager, X, Y);
+        BoardReveal(&Lazy, X, Y);
+        while(BoardFlood(&Lazy, INT_MAX));
+        
+        int Around = 0;
+        int Zone = 0;
+        for(int NY = Y - 1; NY <= Y + 1; ++NY) {
+            for(int NX = X - 1; NX <= X + 1; ++NX) {
+                if(BoardContains(&Eager, NX, NY)) {
+                    Around += BoardGetBit(&Eager, Eager.Bombs, NX, NY);
+                    ++Zone;
+                }
+            }
+        }
+        
+        int Different = CountBombs(&Eager) != Bombs || BoardGetBit(&Eager, Eager.Bombs, X, Y) || (!Eager.Playing && !Eager.Win);
+        if(Bombs <= Tiles - Zone) {
+            Different |= Around != 0 || CellType(Eager.Cells[BoardCell(&Eager, X, Y)]) != EMPTY;
+        }
+        if(Flagged && Bombs > 0) {
+            Different |= !(Eager.Cells[BoardCell(&Eager, FlagX, FlagY)] & CELL_FLAGGED);
+        }
+        
+        memcpy(Counted, Eager.Cells, Cells);
+        CalculateNumbers(&Eager);
+        Different |= memcmp(Counted, Eager.Cells, Cells) != 0;
+        
+        Lazy.LazyNumbers = 0;
+        CalculateNumbers(&Lazy);
+        Different |= memcmp(Eager.Cells, Lazy.Cells, Cells) != 0 || Eager.HiddenSafe != Lazy.HiddenSafe;
+        
+        Wrong += Different;
+        free(EagerMemory);
+        free(LazyMemory);
+        free(Counted);
+    }
+    
+    JobsStop(&Jobs);
+    printf("check opening: %d games, %d went wrong%s\n", Games, Wrong, Check(Wrong == 0));
+}
+
+float RandomFloat(rng* Random, float Min, float Max) {
+    return Min + (Max - Min) * (float)(RngNext(Random) >> 40) / (float)(1 << 24);
+}
+
+// RayTriangleIntersect, returning the distance of the hit or FLT_MAX
+
+float RayTriangleDistance(v3 Origin, v3 Direction, triangle* Triangle) {
+    v3 Edge1 = V3Subtract(Triangle->B, Triangle->A);
+    v3 Edge2 = V3Subtract(Triangle->C, Triangle->A);
+    v3 H = V3CrossProduct(Direction, Edge2);
+    float A = V3DotProduct(Edge1, H);
+    if(A > -PICK_EPSILON && A < PICK_EPSILON) return FLT_MAX;
+    float F = 1.0f / A;
+    v3 S = V3Subtract(Origin, Triangle->A);
+    float U = F * V3DotProduct(S, H);
+    if(U < 0.0f || U > 1.0f) return FLT_MAX;
+    v3 Q = V3CrossProduct(S, Edge1);
+    float V = F * V3DotProduct(Direction, Q);
+    if(V < 0.0f || U + V > 1.0f) return FLT_MAX;
+    float T = F * V3DotProduct(Edge2, Q);
+    return T > PICK_EPSILON ? T : FLT_MAX;
+}
+
+// Nearest hit one triangle at a time, as picking did before the packs
+
+int PickMeshEach(float* Vertices, int TriangleCount, v3 Origin, v3 Direction, pickHit* Hit) {
+    int Result = 0;
+    for(int Index = 0; Index < TriangleCount; ++Index) {
+        float* Corner = &Vertices[Index * 9];
+        triangle Triangle = {{Corner[0], Corner[1], Corner[2]}, {Corner[3], Corner[4], Corner[5]}, {Corner[6], Corner[7], Corner[8]}};
+        float T = RayTriangleDistance(Origin, Direction, &Triangle);
+        if(T < Hit->T) {
+            Hit->T = T;
+            Hit->Triangle = Index;
+            Result = 1;
+        }
+    }
+    return Result;
+}
+
+// Whether the ray meets Rectangle drawn at tile X, Y, as PickMeshAt asks
+
+int PickTileMesh(pickMesh* Rectangle, v3 Origin, v3 Direction, int X, int Y) {
+    pickHit Hit = {.T = FLT_MAX};
+    return PickMeshRay(Rectangle, V3Subtract(Origin, (v3){X, Y, 0.0f}), Direction, &Hit);
+}
+
+// Tile under the mouse found the way PickTile does, with the board as the
+// visible range and Edge as PICK_EDGE, or -1
+
+int PickTilePlane(pickMesh* Rectangle, v3 Origin, v3 Direction, int Width, int Height, float Edge) {
+    
+    v3 Hit;
+    if(!PickRayPlane(Origin, Direction, 0.0f, &Hit)) {
+        return -1;
+    }
+    
+    int FirstX = (int)ceilf(Hit.X - 0.5f - Edge);
+    int FirstY = (int)ceilf(Hit.Y - 0.5f - Edge);
+    int LastX = (int)floorf(Hit.X + 0.5f + Edge);
+    int LastY = (int)floorf(Hit.Y + 0.5f + Edge);
+    
+    int Clamped = FirstX < 0 || FirstY < 0 || LastX > Width - 1 || LastY > Height - 1;
+    if(FirstX < 0) FirstX = 0;
+    if(FirstY < 0) FirstY = 0;
+    if(LastX > Width - 1) LastX = Width - 1;
+    if(LastY > Height - 1) LastY = Height - 1;
+    
+    if(!Clamped && FirstX == LastX && FirstY == LastY) {
+        return FirstY * Width + FirstX;
+    }
+    
+    for(int TileY = FirstY; TileY <= LastY; ++TileY) {
+        for(int TileX = FirstX; TileX <= LastX; ++TileX) {
+            if(PickTileMesh(Rectangle, Origin, Direction, TileX, TileY)) {
+                return TileY * Width + TileX;
+            }
+        }
+    }
+    return -1;
+}
+
+// Rays against one mesh of many triangles, tested one at a time and a pack
+// at a time, then against scenes of many small meshes, tested one instance
+// at a time and through the hierarchy. Both ways must find the same hits.
+// Last the mouse hovering a board, as every frame picks the tile under it.
+
+void BenchPick() {
+    
+    rng Rays;
+    RngSeed(&Rays, 47);
+    
+    // A bumpy 32x32 grid of quads, 2048 triangles
+    
+    int Side = 32;
+    int TriangleCount = Side * Side * 2;
+    float* Vertices = malloc(TriangleCount * 9 * sizeof(float));
+    float* Heights = malloc((Side + 1) * (Side + 1) * sizeof(float));
+    for(int Index = 0; Index < (Side + 1) * (Side + 1); ++Index) {
+        Heights[Index] = RandomFloat(&Rays, -0.5f, 0.5f);
+    }
+    
+    for(int Y = 0; Y < Side; ++Y) {
+        for(int X = 0; X < Side; ++X) {
+            float Corners[4][3] = {
+                {X, Y, Heights[Y * (Side + 1) + X]},
+                {X, Y + 1, Heights[(Y + 1) * (Side + 1) + X]},
+                {X + 1, Y + 1, Heights[(Y + 1) * (Side + 1) + X + 1]},
+                {X + 1, Y, Heights[Y * (Side + 1) + X + 1]},
+            };
+            int Order[6] = {0, 1, 2, 0, 2, 3};
+            float* Vertex = &Vertices[(Y * Side + X) * 18];
+            for(int Corner = 0; Corner < 6; ++Corner) {
+                memcpy(&Vertex[Corner * 3], Corners[Order[Corner]], 3 * sizeof(float));
+            }
+        }
+    }
+    
+    pickMesh Mesh;
+    void* MeshMemory = malloc(PickMeshMemorySize(TriangleCount));
+    PickMeshInit(&Mesh, MeshMemory, Vertices, TriangleCount, 3);
+    
+    int RayCount = 20000;
+    v3* Origins = malloc(RayCount * sizeof(v3));
+    v3* Directions = malloc(RayCount * sizeof(v3));
+    for(int Ray = 0; Ray < RayCount; ++Ray) {
+        Origins[Ray] = (v3){RandomFloat(&Rays, 0.0f, Side), RandomFloat(&Rays, 0.0f, Side), -10.0f};
+        Directions[Ray] = (v3){RandomFloat(&Rays, -0.5f, 0.5f), RandomFloat(&Rays, -0.5f, 0.5f), 1.0f};
+    }
+    
+    pickHit* Found[2];
+    double Time[2];
+    for(int Packed = 0; Packed < 2; ++Packed) {
+        Found[Packed] = malloc(RayCount * sizeof(pickHit));
+        double Begin = GetSeconds();
+        for(int Ray = 0; Ray < RayCount; ++Ray) {
+            pickHit* Hit = &Found[Packed][Ray];
+            *Hit = (pickHit){FLT_MAX, 0.0f, 0.0f, -1, -1};
+            if(Packed) {
+                PickMeshRay(&Mesh, Origins[Ray], Directions[Ray], Hit);
+            } else {
+                PickMeshEach(Vertices, TriangleCount, Origins[Ray], Directions[Ray], Hit);
+            }
+        }
+        Time[Packed] = (GetSeconds() - Begin) / RayCount;
+    }
+    
+    int Different = 0;
+    int Hits = 0;
+    for(int Ray = 0; Ray < RayCount; ++Ray) {
+        Different += Found[0][Ray].Triangle != Found[1][Ray].Triangle || Found[0][Ray].T != Found[1][Ray].T;
+        Hits += Found[1][Ray].Triangle >= 0;
+    }
+    free(Found[0]);
+    free(Found[1]);
+    
+    printf("pick mesh of %d triangles, %d wide packs: one at a time %8.3f us, packed %8.3f us (%.1fx), %d of %d rays hit, %d differ%s\n",
+           TriangleCount, PICK_WIDTH, Time[0] * 1e6, Time[1] * 1e6, Time[0] / Time[1], Hits, RayCount, Different, Check(Different == 0));
+    
+    // Scenes of cubes scattered in a box that grows with their count
+    
+    float Cube[36 * 3];
+    int Faces[6][4] = {{0, 2, 3, 1}, {4, 5, 7, 6}, {0, 1, 5, 4}, {2, 6, 7, 3}, {0, 4, 6, 2}, {1, 3, 7, 5}};
+    for(int Face = 0; Face < 6; ++Face) {
+        int Order[6] = {0, 1, 2, 0, 2, 3};
+        for(int Corner = 0; Corner < 6; ++Corner) {
+            int Index = Faces[Face][Order[Corner]];
+            Cube[(Face * 6 + Corner) * 3 + 0] = Index & 1 ? 0.5f : -0.5f;
+            Cube[(Face * 6 + Corner) * 3 + 1] = Index & 2 ? 0.5f : -0.5f;
+            Cube[(Face * 6 + Corner) * 3 + 2] = Index & 4 ? 0.5f : -0.5f;
+        }
+    }
+    
+    pickMesh CubeMesh;
+    void* CubeMemory = malloc(PickMeshMemorySize(12));
+    PickMeshInit(&CubeMesh, CubeMemory, Cube, 12, 3);
+    
+    int Counts[] = {16, 1000, 100000};
+    for(int Index = 0; Index < COUNT(Counts); ++Index) {
+        
+        int Count = Counts[Index];
+        float Size = 4.0f * cbrtf((float)Count);
+        
+        pickScene Scene;
+        void* SceneMemory = malloc(PickSceneMemorySize(Count));
+        PickSceneInit(&Scene, SceneMemory, Count);
+        for(int Instance = 0; Instance < Count; ++Instance) {
+            matrix Model = MatrixTranslation((v3){RandomFloat(&Rays, 0.0f, Size), RandomFloat(&Rays, 0.0f, Size), RandomFloat(&Rays, 0.0f, Size)});
+            float Scale = RandomFloat(&Rays, 0.5f, 2.0f);
+            Model.M[0][0] = Scale;
+            Model.M[1][1] = Scale * 0.5f;
+            Model.M[2][2] = Scale;
+            PickSceneSet(&Scene, Instance, &CubeMesh, &Model);
+        }
+        
+        double Begin = GetSeconds();
+        PickSceneBuild(&Scene);
+        double Build = GetSeconds() - Begin;
+        
+        int SceneRays = Count >= 100000 ? 200 : 2000;
+        Different = 0;
+        Hits = 0;
+        double Each = 0.0, Tree = 0.0;
+        
+        for(int Ray = 0; Ray < SceneRays; ++Ray) {
+            
+            v3 Origin = {RandomFloat(&Rays, 0.0f, Size), RandomFloat(&Rays, 0.0f, Size), -10.0f};
+            v3 Direction = {RandomFloat(&Rays, -0.3f, 0.3f), RandomFloat(&Rays, -0.3f, 0.3f), 1.0f};
+            
+            pickHit Expected = {FLT_MAX, 0.0f, 0.0f, -1, -1};
+            Begin = GetSeconds();
+            for(int Instance = 0; Instance < Count; ++Instance) {
+                pickInstance* Placed = &Scene.Instances[Instance];
+                v3 ModelOrigin = V3TransformCoord(&Origin, &Placed->Inverse);
+                v3 ModelDirection = V3TransformNormal(&Direction, &Placed->Inverse);
+                if(PickMeshRay(Placed->Mesh, ModelOrigin, ModelDirection, &Expected)) {
+                    Expected.Instance = Instance;
+                }
+            }
+            Each += GetSeconds() - Begin;
+            
+            pickHit Hit = {FLT_MAX, 0.0f, 0.0f, -1, -1};
+            Begin = GetSeconds();
+            PickSceneRay(&Scene, Origin, Direction, &Hit);
+            Tree += GetSeconds() - Begin;
+            
+            // Equally near hits on different cubes may come in either order
+            
+            Different += Hit.T != Expected.T;
+            Hits += Hit.Instance >= 0;
+        }
+        
+        printf("pick scene of %6d cubes: build %8.3f ms, every instance %10.3f us, hierarchy %8.3f us (%.0fx), %d of %d rays hit, %d differ%s\n",
+               Count, Build * 1e3, Each / SceneRays * 1e6, Tree / SceneRays * 1e6, Each / Tree, Hits, SceneRays, Different, Check(Different == 0));
+        
+        free(SceneMemory);
+    }
+    
+    // A camera as CameraUpdate builds it, over a board of unit tiles
+    // centered on their coordinates. Every tile scanned in order, as
+    // picking used to, against the plane and the tiles around its point.
+    
+    float Rectangle[] = {
+        -0.5f, -0.5f, 0.0f, -0.5f, 0.5f, 0.0f, 0.5f, 0.5f, 0.0f,
+        -0.5f, -0.5f, 0.0f, 0.5f, 0.5f, 0.0f, 0.5f, -0.5f, 0.0f,
+    };
+    pickMesh RectangleMesh;
+    void* RectangleMemory = malloc(PickMeshMemorySize(2));
+    PickMeshInit(&RectangleMesh, RectangleMemory, Rectangle, 2, 3);
+    
+    int BoardWidth = 200;
+    int BoardHeight = 160;
+    int ClientWidth = 1280;
+    int ClientHeight = 720;
+    float Near = 1.0f;
+    float Far = 200.0f;
+    float AspectRatio = (float)ClientWidth / (float)ClientHeight;
+    matrix Projection = {{
+        {2.0f * Near / AspectRatio, 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f * Near, 0.0f, 0.0f},
+        {0.0f, 0.0f, Far / (Far - Near), 1.0f},
+        {0.0f, 0.0f, Near * Far / (Near - Far), 0.0f},
+    }};
+    
+    int Hovers = 200;
+    int Scanned = 0;
+    Different = 0;
+    Hits = 0;
+    double Scan = 0.0, Plane = 0.0;
+    
+    for(int Hover = 0; Hover < Hovers; ++Hover) {
+        
+        // Some of the views hang past the board's edges
+        
+        v3 Position = {RandomFloat(&Rays, -20.0f, BoardWidth + 20.0f), RandomFloat(&Rays, -20.0f, BoardHeight + 20.0f), RandomFloat(&Rays, -100.0f, -2.0f)};
+        matrix InverseView = MatrixTranslation(Position);
+        
+        v3 Origin, Direction;
+        PickMouseRay(RngBelow(&Rays, ClientWidth), RngBelow(&Rays, ClientHeight), ClientWidth, ClientHeight, &Projection, &InverseView, &Origin, &Direction);
+        V3Normalize(&Direction);
+        
+        int Expected = -1;
+        double Begin = GetSeconds();
+        for(int TileY = 0; TileY < BoardHeight && Expected < 0; ++TileY) {
+            for(int TileX = 0; TileX < BoardWidth && Expected < 0; ++TileX) {
+                if(PickTileMesh(&RectangleMesh, Origin, Direction, TileX, TileY)) {
+                    Expected = TileY * BoardWidth + TileX;
+                }
+            }
+        }
+        Scan += GetSeconds() - Begin;
+        
+        Begin = GetSeconds();
+        int Tile = PickTilePlane(&RectangleMesh, Origin, Direction, BoardWidth, BoardHeight, 0.01f);
+        Plane += GetSeconds() - Begin;
+        
+        Different += Tile != Expected;
+        Hits += Expected >= 0;
+        ++Scanned;
+    }
+    
+    printf("pick hover over %dx%d tiles: scan %10.3f us, plane %8.3f us (%.0fx), %d of %d over a tile, %d differ%s\n",
+           BoardWidth, BoardHeight, Scan / Scanned * 1e6, Plane / Scanned * 1e6, Scan / Plane, Hits, Scanned, Different, Check(Different == 0));
+    
+    free(RectangleMemory);
+    free(CubeMemory);
+    free(MeshMemory);
+    free(Origins);
+    free(Directions);
+    free(Heights);
+    free(Vertices);
+}
+
+// Kind 0 is a translation, 1 an affine matrix of a rotation, scale and
+// translation, and 2 a general one, as a projection times a view
+
+matrix RandomMatrix(rng* Random, int Kind) {
+    
+    matrix M = MatrixTranslation((v3){RandomFloat(Random, -100.0f, 100.0f), RandomFloat(Random, -100.0f, 100.0f), RandomFloat(Random, -100.0f, 100.0f)});
+    if(Kind == 0) {
+        return M;
+    }
+    
+    float Angle = RandomFloat(Random, 0.0f, 6.2831853f);
+    float Scale = RandomFloat(Random, 0.25f, 4.0f);
+    M.M[0][0] = cosf(Angle) * Scale;
+    M.M[0][1] = sinf(Angle) * Scale;
+    M.M[1][0] = -sinf(Angle) * Scale;
+    M.M[1][1] = cosf(Angle) * Scale;
+    M.M[2][2] = Scale;
+    for(int Row = 0; Row < 3; ++Row) {
+        for(int Column = 0; Column < 3; ++Column) {
+            M.M[Row][Column] += RandomFloat(Random, -0.1f, 0.1f);
+        }
+    }
+    if(Kind == 1) {
+        return M;
+    }
+    
+    float Near = RandomFloat(Random, 0.1f, 2.0f);
+    float Far = RandomFloat(Random, 50.0f, 1000.0f);
+    matrix Projection = {{
+        {2.0f * Near / RandomFloat(Random, 1.0f, 2.0f), 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f * Near, 0.0f, 0.0f},
+        {0.0f, 0.0f, Far / (Far - Near), 1.0f},
+        {0.0f, 0.0f, Near * Far / (Near - Far), 0.0f},
+    }};
+    return MatrixMultiplyScalar(&M, &Projection);
+}
+
+// Largest entry of M times Inverse minus the identity, in doubles
+
+double InverseError(matrix* M, matrix* Inverse) {
+    double Error = 0.0;
+    for(int Row = 0; Row < 4; ++Row) {
+        for(int Column = 0; Column < 4; ++Column) {
+            double Sum = Row == Column ? -1.0 : 0.0;
+            for(int Index = 0; Index < 4; ++Index) {
+                Sum += (double)M->M[Row][Index] * (double)Inverse->M[Index][Column];
+            }
+            Error = fabs(Sum) > Error ? fabs(Sum) : Error;
+        }
+    }
+    return Error;
+}
+
+// Matrix routines against their scalar versions: time per call, whether
+// transforms give the same bits, and how far each inverse is from exact,
+// which for the new one must be no further
+
+void BenchMaths() {
+    
+    enum { COUNT = 1024, REPEATS = 2000 };
+    char* Kinds[] = {"translation", "affine", "general"};
+    
+    rng Random;
+    RngSeed(&Random, 53);
+    
+    matrix* Matrices = malloc(COUNT * sizeof(matrix));
+    matrix* Results = malloc(COUNT * sizeof(matrix));
+    matrix* Expected = malloc(COUNT * sizeof(matrix));
+    assert(Matrices && Results && Expected);
+    
+    for(int Kind = 0; Kind < 3; ++Kind) {
+        
+        for(int Index = 0; Index < COUNT; ++Index) {
+            Matrices[Index] = RandomMatrix(&Random, Kind);
+        }
+        
+        double Time[2];
+        for(int Simd = 0; Simd < 2; ++Simd) {
+            double Begin = GetSeconds();
+            for(int Repeat = 0; Repeat < REPEATS; ++Repeat) {
+                for(int Index = 0; Index < COUNT; ++Index) {
+                    if(Simd) {
+                        MatrixInverse(&Matrices[Index], &Results[Index]);
+                    } else {
+                        MatrixInverseScalar(&Matrices[Index], &Expected[Index]);
+                    }
+                }
+            }
+            Time[Simd] = (GetSeconds() - Begin) / ((double)REPEATS * COUNT);
+        }
+        
+        double Error[2] = {0.0, 0.0};
+        for(int Index = 0; Index < COUNT; ++Index) {
+            double Scalar = InverseError(&Matrices[Index], &Expected[Index]);
+            double Simd = InverseError(&Matrices[Index], &Results[Index]);
+            Error[0] = Scalar > Error[0] ? Scalar : Error[0];
+            Error[1] = Simd > Error[1] ? Simd : Error[1];
+        }
+        
+        printf("maths inverse %-11s: cofactors %7.2f ns, new %7.2f ns (%.1fx), largest error of M * inverse - I %.2e and %.2e%s\n",
+               Kinds[Kind], Time[0] * 1e9, Time[1] * 1e9, Time[0] / Time[1], Error[0], Error[1], Check(Error[1] <= Error[0]));
+    }
+    
+    // Transforms by general matrices. MatrixMultiply is the scalar product.
+    
+    for(int Index = 0; Index < COUNT; ++Index) {
+        Matrices[Index] = RandomMatrix(&Random, 2);
+    }
+    
+    double Time[2];
+    int Different;
+    v3 Points[COUNT];
+    v3 Transformed[2][COUNT];
+    for(int Index = 0; Index < COUNT; ++Index) {
+        Points[Index] = (v3){RandomFloat(&Random, -100.0f, 100.0f), RandomFloat(&Random, -100.0f, 100.0f), RandomFloat(&Random, -100.0f, 100.0f)};
+    }
+    
+    for(int Normal = 0; Normal < 2; ++Normal) {
+        for(int Simd = 0; Simd < 2; ++Simd) {
+            double Begin = GetSeconds();
+            for(int Repeat = 0; Repeat < REPEATS; ++Repeat) {
+                for(int Index = 0; Index < COUNT; ++Index) {
+                    matrix* M = &Matrices[Repeat % COUNT];
+                    Transformed[Simd][Index] = Normal ? (Simd ? V3TransformNormal(&Points[Index], M) : V3TransformNormalScalar(&Points[Index], M))
+                        : (Simd ? V3TransformCoord(&Points[Index], M) : V3TransformCoordScalar(&Points[Index], M));
+                }
+            }
+            Time[Simd] = (GetSeconds() - Begin) / ((double)REPEATS * COUNT);
+        }
+        Different = memcmp(Transformed[0], Transformed[1], sizeof(Transformed[0])) != 0;
+        printf("maths %-16s: scalar    %7.2f ns, new %7.2f ns (%.1fx), %s%s\n", Normal ? "transform normal" : "transform coord",
+               Time[0] * 1e9, Time[1] * 1e9, Time[0] / Time[1], Different ? "results differ" : "same bits", Check(!Different));
+    }
+    
+    // Frustum planes against the clip test, for the game's projection
+    // seen from random camera positions
+    
+    matrix Projection = {{
+        {2.0f, 0.0f, 0.0f, 0.0f},
+        {0.0f, 2.0f, 0.0f, 0.0f},
+        {0.0f, 0.0f, 100.0f / 99.0f, 1.0f},
+        {0.0f, 0.0f, -100.0f / 99.0f, 0.0f},
+    }};
+    
+    int Inside = 0;
+    int Wrong = 0;
+    plane Planes[PLANE_COUNT];
+    
+    for(int Index = 0; Index < COUNT; ++Index) {
+        
+        v3 Position = {RandomFloat(&Random, -50.0f, 50.0f), RandomFloat(&Random, -50.0f, 50.0f), RandomFloat(&Random, -50.0f, 0.0f)};
+        matrix View = MatrixTranslation(V3MultiplyScalar(Position, -1.0f));
+        matrix ViewProjection = MatrixMultiply(&View, &Projection);
+        MatrixFrustumPlanes(&ViewProjection, Planes);
+        
+        for(int Point = 0; Point < COUNT; ++Point) {
+            
+            v3 P = V3Add(Position, Points[Point]);
+            float* C[4] = {ViewProjection.M[0], ViewProjection.M[1], ViewProjection.M[2], ViewProjection.M[3]};
+            float Clip[4];
+            for(int Column = 0; Column < 4; ++Column) {
+                Clip[Column] = P.X * C[0][Column] + P.Y * C[1][Column] + P.Z * C[2][Column] + C[3][Column];
+            }
+            
+            int Clipped = fabsf(Clip[0]) <= Clip[3] && fabsf(Clip[1]) <= Clip[3] && Clip[2] >= 0.0f && Clip[2] <= Clip[3];
+            Inside += Clipped;
+            Wrong += Clipped != PlanesContainBox(Planes, PLANE_COUNT, P, P);
+        }
+    }
+    printf("maths frustum planes  : %d of %d points inside, %d disagree with the clip test%s\n", Inside, COUNT * COUNT, Wrong, Check(Wrong == 0));
+    
+    free(Matrices);
+    free(Results);
+    free(Expected);
+}
+
+int ShouldRun(char* Only, char* Name) {
+    return Only == NULL || strcmp(Only, Name) == 0;
+}
+
+// Checks run with everything, on their own by name, or all together with
+// "check", which is quick enough to run after every change
+
+int ShouldCheck(char* Only, char* Name) {
+    return ShouldRun(Only, "check") || ShouldRun(Only, Name);
+}
+
+int main(int ArgumentCount, char** Arguments) {
+    
+    // Run everything, or only the benchmark named on the command line.
+    // Exits with 1 when a comparison went wrong.
+    
+    char* Only = ArgumentCount > 1 ? Arguments[1] : NULL;
+    
+    srand(1);
+    RngSeed(&Random, 1);
+    
+    if(ShouldRun(Only, "games")) BenchGames(2.0);
+    if(ShouldRun(Only, "flood")) BenchFlood();
+    if(ShouldRun(Only, "numbers")) BenchNumbers();
+    if(ShouldRun(Only, "placement")) BenchPlacement();
+    if(ShouldRun(Only, "seeds")) BenchSeeds();
+    if(ShouldRun(Only, "chunks")) BenchChunks();
+    if(ShouldRun(Only, "world")) BenchWorld();
+    if(ShouldRun(Only, "regions")) BenchRegions();
+    if(ShouldRun(Only, "move")) BenchMove();
+    if(ShouldRun(Only, "clicks")) BenchClicks();
+    if(ShouldRun(Only, "scan")) BenchScan();
+    if(ShouldRun(Only, "kernels")) BenchKernels();
+    if(ShouldRun(Only, "chords")) BenchChords();
+    if(ShouldRun(Only, "parallel")) BenchParallel();
+    if(ShouldRun(Only, "bands")) BenchBands();
+    if(ShouldRun(Only, "slices")) BenchSlices();
+    if(ShouldRun(Only, "lazy")) BenchLazy();
+    if(ShouldRun(Only, "opening")) BenchOpening();
+    if(ShouldRun(Only, "pick")) BenchPick();
+    if(ShouldRun(Only, "maths")) BenchMaths();
+    
+    if(ShouldCheck(Only, "check-win")) CheckWin();
+    if(ShouldCheck(Only, "check-parallel")) CheckParallel();
+    if(ShouldCheck(Only, "check-bands")) CheckBands();
+    if(ShouldCheck(Only, "check-slices")) CheckSlices();
+    if(ShouldCheck(Only, "check-lazy")) CheckLazy();
+    if(ShouldCheck(Only, "check-opening")) CheckOpening();
+    
+    if(Failures > 0) {
+        printf("%d comparisons went wrong\n", Failures);
+        return 1;
+    }
+    return 0;
+}
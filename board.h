@@ -0,0 +1,1961 @@
+// Game rules, independent of the OS and graphics API
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "random.h"
+#include "jobs.h"
+
+// Neighbor counting uses the widest of these the compiler targets
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BOARD_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOARD_SSE2
+#endif
+
+// Kernels are inlined into the size specific versions that call them, see
+// BoardKernel
+
+#ifdef _MSC_VER
+#define BOARD_INLINE static __forceinline
+#else
+#define BOARD_INLINE static inline __attribute__((always_inline))
+#endif
+
+// Tile indices are ints, so keep well below INT_MAX
+
+#define MAX_TILES (1 << 30)
+
+// Bombs are generated in square chunks, one bit plane word wide
+
+#define CHUNK_SIZE 64
+
+// Boards of this many tiles or more flood, place bombs and count numbers
+// on the board's job pool, when it has one, see BoardParallel
+
+#define PARALLEL_TILES (1 << 20)
+
+// Tiles a flood opens per frame in the game, see BoardFlood
+
+#define BOARD_FLOOD_BUDGET 100000
+
+// Cells a requeue scan looks at for each tile of a flood's budget, see
+// FloodRequeue
+
+#define FLOOD_SCAN_CELLS 8
+
+// BORDER is the type of the cells around the board, see CELL_BORDER
+
+enum {EMPTY, NUMBER, BOMB, BORDER};
+
+// Board sizes with kernels of their own: beginner, intermediate and expert
+
+enum {KERNEL_GENERIC, KERNEL_9X9, KERNEL_16X16, KERNEL_30X16};
+
+// A tile's whole state is one byte: its number in the low four bits, then
+// whether it is a bomb, revealed, flagged and the bomb that ended the game.
+// Border cells are a bomb with a count, which no tile can be, and revealed,
+// so floods, chords and neighbor counts pass them by without bounds checks.
+
+#define CELL_COUNT 0x0F
+#define CELL_BOMB 0x10
+#define CELL_REVEALED 0x20
+#define CELL_FLAGGED 0x40
+#define CELL_HIT 0x80
+#define CELL_BORDER (CELL_COUNT | CELL_BOMB | CELL_REVEALED)
+
+// Tiles of chunks not counted yet, see BoardCellValue. Also a bomb with a
+// count, so code that doesn't count them first takes them for the border.
+
+#define CELL_UNCOUNTED (CELL_COUNT | CELL_BOMB)
+
+// Types
+
+typedef struct {
+    int X;
+    int Y;
+} point;
+
+// One tile as seen from outside the board
+
+typedef struct {
+    unsigned char Type;
+    unsigned char Hit;
+    unsigned char Visible;
+    unsigned char Flagged;
+    unsigned char BombsNearAmount;
+} tile;
+
+// Ring buffer of tile indices
+
+typedef struct {
+    int* Items;
+    int Capacity;
+    int First;
+    int Length;
+} queue;
+
+// Connected empty tiles, each region listed as the cells of its empty
+// tiles followed by the numbers around them, see BoardBuildRegions. Labels
+// holds the region of every cell, -1 for cells that aren't empty tiles.
+// Cells are in row order.
+
+typedef struct {
+    int* Labels;
+    int* CellStarts;
+    int* Cells;
+    int* BorderStarts;
+    int* Border;
+    int Count;
+    int Built;
+    int Stale;
+} regions;
+
+// Cells holds one byte per tile in row order, see CELL_COUNT, inside a
+// ring of border cells, so rows are CellStride = Width + 2 apart and a
+// tile's neighbors are its cell index plus the Offsets. Tiles are passed
+// around as cell indices, see BoardCell. Bombs are also kept as a bit
+// plane, 64 tiles per word, for counting and placing them. Each row starts
+// on a new word and has an empty word on both sides, and there is an empty
+// row above and below the board, so the plane needs no bounds checks
+// either. Storage comes from one block handed to BoardInit, see
+// BoardMemorySize.
+// Random is the board's own generator, reseeded from Seed every game.
+// HiddenSafe counts the tiles without bombs that are still hidden, the game
+// is won when it reaches 0.
+// Jobs is a thread pool for floods of large boards, set by the caller
+// after BoardInit, or NULL to flood on the calling thread only.
+// FloodBudget, when not 0, is how many tiles a flood opens before it stops
+// and waits for BoardFlood to go on, set by the caller too. The rest of it
+// waits in Frontier, or in Parallel for a parallel flood. FloodOverflow is
+// set when the frontier dropped tiles, and FloodScan is 1 + the next cell
+// of the scan that queues them again, or 0 when none is going on, see
+// FloodRequeue.
+// LazyNumbers, also set by the caller, leaves a new game's numbers
+// uncounted, each chunk is counted the first time a tile in or next to it
+// is looked at, see BoardCellValue.
+// SafeOpening, also set by the caller, leaves a new game's bombs to its
+// first reveal, which always opens an area, see BoardPlaceOpening.
+// Otherwise the board is made by BoardNewGame, and a bomb under the first
+// reveal is moved away.
+
+typedef struct parallelFlood parallelFlood;
+
+typedef struct {
+    jobs* Jobs;
+    parallelFlood* Parallel;
+    int FloodBudget;
+    int FloodOverflow;
+    int FloodScan;
+    int LazyNumbers;
+    int SafeOpening;
+    unsigned long long* Bombs;
+    unsigned char* Cells;
+    queue Frontier;
+    regions Regions;
+    rng Random;
+    unsigned long long Seed;
+    int Offsets[8];
+    int Kernel;
+    int CellStride;
+    int RowWords;
+    int PlaneStride;
+    int Width;
+    int Height;
+    int BombCount;
+    int HiddenSafe;
+    int Flags;
+    int Playing;
+    int FirstPick;
+    int Win;
+} board;
+
+// Scratch space of one thread of a parallel flood. Out collects the cells
+// past the edges of its chunks for the caller to hand on, see FloodSend.
+
+typedef struct {
+    int* Queue;
+    int* Out;
+    int OutLength;
+    int OutCapacity;
+    int Revealed;
+} floodThread;
+
+// A flood split over the board's chunks. Pending marks, as a plane like
+// Bombs, the tiles a chunk has to reveal when it next runs, and Active
+// lists the ActiveCount chunks waiting to run, oldest first, with Queued
+// set for each, see FloodEmptyParallel.
+
+struct parallelFlood {
+    board* Board;
+    unsigned long long* Pending;
+    int* Active;
+    unsigned char* Queued;
+    int ActiveCount;
+    int ChunksX;
+    floodThread Threads[JOBS_MAX_THREADS];
+};
+
+// Arguments of PlaceBombs for its jobs, see PlaceBombsBand
+
+typedef struct {
+    board* Board;
+    int Bombs;
+    int* Excluded;
+    int ExcludedCount;
+} bombPlacement;
+
+// Declarations
+
+void BoardInit(board* Board, void* Memory, int Width, int Height);
+void BoardNewGame(board* Board, int Bombs, unsigned long long Seed);
+void BoardReveal(board* Board, int X, int Y);
+void BoardRevealCell(board* Board, int Cell);
+void BoardFlag(board* Board, int X, int Y);
+void BoardChord(board* Board, int X, int Y);
+
+tile BoardGetTile(board* Board, int X, int Y);
+BOARD_INLINE unsigned char BoardCellValue(board* Board, int Cell);
+void BoardCountCell(board* Board, int Cell);
+void BoardCountAround(board* Board, int Cell);
+void BoardCountChunk(board* Board, int ChunkX, int ChunkY);
+tile CellToTile(unsigned char Cell, int Playing);
+int CellType(unsigned char Cell);
+int BoardGetType(board* Board, int X, int Y);
+int BoardContains(board* Board, int X, int Y);
+int BoardCell(board* Board, int X, int Y);
+point BoardCellPosition(board* Board, int Cell);
+int BoardCellCount(int Width, int Height);
+int BoardSizeFits(int Width, int Height);
+void BoardSetBorder(board* Board);
+int BoardCountNeighbors(board* Board, int Cell, int Type);
+int BoardKernel(int Width, int Height);
+
+unsigned long long* BoardPlaneWord(board* Board, unsigned long long* Plane, int X, int Y);
+int BoardGetBit(board* Board, unsigned long long* Plane, int X, int Y);
+void BoardSetBit(board* Board, unsigned long long* Plane, int X, int Y);
+void BoardClearBit(board* Board, unsigned long long* Plane, int X, int Y);
+void BoardFlipBit(board* Board, unsigned long long* Plane, int X, int Y);
+unsigned long long BoardRowMask(board* Board, int Word);
+
+void FloodEmpty(board* Board, int Start);
+void FloodEmptyMany(board* Board, int* Starts, int Count);
+int FloodEmptyBudget(board* Board, int* Starts, int Count, int Budget);
+int BoardFlood(board* Board, int Budget);
+int BoardFlooding(board* Board);
+void BoardStopFlood(board* Board);
+int FloodEmptyParallel(board* Board, int* Starts, int Count, int Budget);
+parallelFlood* FloodParallelStart(board* Board);
+void FloodChunk(void* Data, int Job, int Thread);
+void FloodSend(floodThread* Thread, int Cell);
+void FloodStitch(parallelFlood* Flood, int* Cells, int Count);
+void BoardOpenEmpty(board* Board, int* Starts, int Count);
+void BoardBuildRegions(board* Board);
+void BoardFreeRegions(board* Board);
+void BoardRevealRegion(board* Board, int Region);
+int RegionFind(int* Labels, int Tile);
+void RegionUnion(int* Labels, int A, int B);
+void CalculateNumbers(board* Board);
+void CalculateNumbersRow(board* Board, int Y);
+void CalculateNumbersBand(void* Data, int Band, int Thread);
+int BoardParallel(board* Board);
+int BoardBands(board* Board);
+BOARD_INLINE void WriteCells(unsigned char* Cells, int Count, unsigned long long* Sum, unsigned long long Bombs);
+void RevealNumbersAround(board* Board, int Cell);
+
+size_t BoardMemorySize(int Width, int Height);
+BOARD_INLINE unsigned long long SpreadBits(unsigned long long Bits);
+
+int QueueAdd(queue* Queue, int Index);
+int QueuePop(queue* Queue);
+int BoardFrontierCapacity(int Width, int Height);
+int FloodRequeue(board* Board, int Budget);
+int CountTrailingZeros(unsigned long long Value);
+int CountBits(unsigned long long Value);
+int BoardRevealTile(board* Board, int Cell);
+int BoardNthSafeTile(board* Board, int N);
+void PlaceBombs(board* Board, int Bombs, int* Excluded, int ExcludedCount);
+void PlaceBombsBand(void* Data, int Band, int Thread);
+void PlaceChunkBombs(board* Board, int ChunkX, int ChunkY, int Bombs, int* Excluded, int ExcludedCount);
+int ChunkBombQuota(board* Board, int ChunkX, int ChunkY, int Bombs, int* Excluded, int ExcludedCount);
+long long ChunkFreeTilesBefore(board* Board, int ChunkX, int ChunkY, int* Excluded, int ExcludedCount);
+int ChunkRankToTile(board* Board, int X0, int Y0, int Width, int Height, int Rank, int* Excluded, int ExcludedCount);
+void ChunkBombsByDensity(unsigned long long Seed, int ChunkX, int ChunkY, unsigned int Density, unsigned long long* Rows);
+unsigned long long ChunkKey(int ChunkX, int ChunkY);
+void MoveBomb(board* Board, int X, int Y);
+void BoardPlaceOpening(board* Board, int Cell);
+void BoardAddBomb(board* Board, int X, int Y);
+void BoardRemoveBomb(board* Board, int X, int Y);
+void BoardAddToNumbers(board* Board, int X, int Y, int Amount);
+
+// Functions
+
+int CountTrailingZeros(unsigned long long Value) {
+#ifdef _MSC_VER
+    unsigned long Index;
+    _BitScanForward64(&Index, Value);
+    return Index;
+#else
+    return __builtin_ctzll(Value);
+#endif
+}
+
+int CountBits(unsigned long long Value) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(Value);
+#else
+    return __builtin_popcountll(Value);
+#endif
+}
+
+// The frontier of a flood is a band around the opened area, so it is sized
+// by the board's perimeter. Odd shaped openings can still outgrow it, which
+// FloodEmpty handles with FloodRequeue.
+
+int BoardFrontierCapacity(int Width, int Height) {
+    long long Capacity = 8 * ((long long)Width + Height) + 1024;
+    if(Capacity > (long long)Width * Height) {
+        Capacity = (long long)Width * Height;
+    }
+    return (int)Capacity;
+}
+
+size_t BoardMemorySize(int Width, int Height) {
+    size_t RowWords = (Width + 63) / 64;
+    size_t PlaneWords = (RowWords + 2) * (Height + 2);
+    return 64 +
+        PlaneWords * sizeof(unsigned long long) +
+        BoardFrontierCapacity(Width, Height) * sizeof(int) +
+        BoardCellCount(Width, Height);
+}
+
+int BoardCellCount(int Width, int Height) {
+    return (Width + 2) * (Height + 2);
+}
+
+// Whether a Width x Height board and its border fit in MAX_TILES cells
+
+int BoardSizeFits(int Width, int Height) {
+    return Width > 0 && Height > 0 && ((long long)Width + 2) * ((long long)Height + 2) <= MAX_TILES;
+}
+
+// Memory must hold BoardMemorySize(Width, Height) zeroed bytes
+
+void BoardInit(board* Board, void* Memory, int Width, int Height) {
+    
+    assert(BoardSizeFits(Width, Height));
+    
+    memset(Board, 0, sizeof(*Board));
+    
+    Board->Width = Width;
+    Board->Height = Height;
+    Board->RowWords = (Width + 63) / 64;
+    Board->PlaneStride = Board->RowWords + 2;
+    Board->CellStride = Width + 2;
+    
+    int Stride = Board->CellStride;
+    int Offsets[8] = {
+        -Stride - 1, -Stride, -Stride + 1,
+        -1,                   1,
+        Stride - 1,  Stride,  Stride + 1,
+    };
+    memcpy(Board->Offsets, Offsets, sizeof(Offsets));
+    Board->Kernel = BoardKernel(Width, Height);
+    
+    // An all zero xoshiro state only ever gives zeros
+    
+    RngSeed(&Board->Random, Board->Seed);
+    
+    size_t PlaneWords = (size_t)Board->PlaneStride * (Height + 2);
+    
+    unsigned char* Data = (unsigned char*)(((size_t)Memory + 63) & ~(size_t)63);
+    
+    Board->Bombs = (unsigned long long*)Data;
+    Data = (unsigned char*)(Board->Bombs + PlaneWords);
+    
+    Board->Frontier.Items = (int*)Data;
+    Board->Frontier.Capacity = BoardFrontierCapacity(Width, Height);
+    Data += Board->Frontier.Capacity * sizeof(*Board->Frontier.Items);
+    
+    Board->Cells = Data;
+    BoardSetBorder(Board);
+}
+
+int BoardContains(board* Board, int X, int Y) {
+    return X >= 0 && Y >= 0 && X < Board->Width && Y < Board->Height;
+}
+
+// Most games are played on the classic sizes, so those get the kernels
+// below with their width and height built in, and the rest share one
+// version that reads them from the board. Setting Kernel to KERNEL_GENERIC
+// runs the shared one on any board.
+
+int BoardKernel(int Width, int Height) {
+    if(Width == 9 && Height == 9) return KERNEL_9X9;
+    if(Width == 16 && Height == 16) return KERNEL_16X16;
+    if(Width == 30 && Height == 16) return KERNEL_30X16;
+    return KERNEL_GENERIC;
+}
+
+// Cell index of a tile, and the way back
+
+int BoardCell(board* Board, int X, int Y) {
+    return (Y + 1) * Board->CellStride + X + 1;
+}
+
+point BoardCellPosition(board* Board, int Cell) {
+    point Position = {Cell % Board->CellStride - 1, Cell / Board->CellStride - 1};
+    return Position;
+}
+
+void BoardSetBorder(board* Board) {
+    
+    int Stride = Board->CellStride;
+    int Last = BoardCellCount(Board->Width, Board->Height) - Stride;
+    
+    memset(Board->Cells, CELL_BORDER, Stride);
+    memset(&Board->Cells[Last], CELL_BORDER, Stride);
+    for(int Row = Stride; Row < Last; Row += Stride) {
+        Board->Cells[Row] = CELL_BORDER;
+        Board->Cells[Row + Stride - 1] = CELL_BORDER;
+    }
+}
+
+// Bit planes
+
+unsigned long long* BoardPlaneWord(board* Board, unsigned long long* Plane, int X, int Y) {
+    return &Plane[(Y + 1) * Board->PlaneStride + 1 + (X >> 6)];
+}
+
+int BoardGetBit(board* Board, unsigned long long* Plane, int X, int Y) {
+    return (*BoardPlaneWord(Board, Plane, X, Y) >> (X & 63)) & 1;
+}
+
+void BoardSetBit(board* Board, unsigned long long* Plane, int X, int Y) {
+    *BoardPlaneWord(Board, Plane, X, Y) |= 1ull << (X & 63);
+}
+
+void BoardClearBit(board* Board, unsigned long long* Plane, int X, int Y) {
+    *BoardPlaneWord(Board, Plane, X, Y) &= ~(1ull << (X & 63));
+}
+
+void BoardFlipBit(board* Board, unsigned long long* Plane, int X, int Y) {
+    *BoardPlaneWord(Board, Plane, X, Y) ^= 1ull << (X & 63);
+}
+
+// Bits of a row word that are on the board
+
+unsigned long long BoardRowMask(board* Board, int Word) {
+    int Bits = Board->Width - Word * 64;
+    return Bits >= 64 ? ~0ull : (1ull << Bits) - 1;
+}
+
+// Bombs have no count, so a cell's bomb and count bits alone tell its type
+
+int CellType(unsigned char Cell) {
+    int Bits = Cell & (CELL_BOMB | CELL_COUNT);
+    return Bits == 0 ? EMPTY : Bits < CELL_BOMB ? NUMBER : Bits == CELL_BOMB ? BOMB : BORDER;
+}
+
+int BoardGetType(board* Board, int X, int Y) {
+    return CellType(BoardCellValue(Board, BoardCell(Board, X, Y)));
+}
+
+tile BoardGetTile(board* Board, int X, int Y) {
+    return CellToTile(BoardCellValue(Board, BoardCell(Board, X, Y)), Board->Playing);
+}
+
+// Lazy numbers
+//
+// Every read of a cell whose chunk may not be counted yet goes through
+// here, and counts the chunk from the bomb plane if it isn't. Counting
+// keeps the revealed, flagged and hit bits like any count, and leaves no
+// tile uncounted, so a chunk is either all CELL_UNCOUNTED or all counted.
+// Boards that aren't lazy never have CELL_UNCOUNTED, which costs them one
+// well predicted compare.
+
+BOARD_INLINE unsigned char BoardCellValue(board* Board, int Cell) {
+    if(Board->Cells[Cell] == CELL_UNCOUNTED) {
+        BoardCountCell(Board, Cell);
+    }
+    return Board->Cells[Cell];
+}
+
+void BoardCountCell(board* Board, int Cell) {
+    point Position = BoardCellPosition(Board, Cell);
+    BoardCountChunk(Board, Position.X / CHUNK_SIZE, Position.Y / CHUNK_SIZE);
+}
+
+// Counts the chunks of a tile and its neighbors, for code that reads or
+// changes the whole 3x3 area
+
+void BoardCountAround(board* Board, int Cell) {
+    BoardCellValue(Board, Cell);
+    for(int Index = 0; Index < 8; ++Index) {
+        BoardCellValue(Board, Cell + Board->Offsets[Index]);
+    }
+}
+
+// A finished game shows every tile
+
+tile CellToTile(unsigned char Cell, int Playing) {
+    tile Tile = {
+        .Type = CellType(Cell),
+        .Hit = (Cell & CELL_HIT) != 0,
+        .Visible = !Playing || (Cell & CELL_REVEALED),
+        .Flagged = (Cell & CELL_FLAGGED) != 0,
+        .BombsNearAmount = Cell & CELL_COUNT,
+    };
+    return Tile;
+}
+
+// Stride is the board's CellStride, a constant in the sized kernels
+
+BOARD_INLINE void RevealNumbersAroundSized(board* Board, int Cell, int Stride) {
+    int Offsets[8] = {-Stride - 1, -Stride, -Stride + 1, -1, 1, Stride - 1, Stride, Stride + 1};
+    for(int Index = 0; Index < 8; ++Index) {
+        int Neighbor = Cell + Offsets[Index];
+        if(CellType(BoardCellValue(Board, Neighbor)) == NUMBER) {
+            BoardRevealTile(Board, Neighbor);
+        }
+    }
+}
+
+void RevealNumbersAround(board* Board, int Cell) {
+    RevealNumbersAroundSized(Board, Cell, Board->CellStride);
+}
+
+int BoardCountNeighbors(board* Board, int Cell, int Type) {
+    int Count = 0;
+    for(int Index = 0; Index < 8; ++Index) {
+        Count += CellType(BoardCellValue(Board, Cell + Board->Offsets[Index])) == Type;
+    }
+    return Count;
+}
+
+// Returns 0 if the queue is full
+
+int QueueAdd(queue* Queue, int Index) {
+    if(Queue->Length == Queue->Capacity) {
+        return 0;
+    }
+    Queue->Items[(Queue->First + Queue->Length) % Queue->Capacity] = Index;
+    ++Queue->Length;
+    return 1;
+}
+
+int QueuePop(queue* Queue) {
+    int Index = Queue->Items[Queue->First];
+    Queue->First = (Queue->First + 1) % Queue->Capacity;
+    --Queue->Length;
+    return Index;
+}
+
+// Reveals a tile, returns 0 if it already was. Every reveal goes through
+// here to keep HiddenSafe right. For a flood this is also its visited set:
+// a flood always runs to completion, so a revealed empty tile never has to
+// be expanded again.
+
+int BoardRevealTile(board* Board, int Cell) {
+    
+    if(Board->Cells[Cell] & CELL_REVEALED) {
+        return 0;
+    }
+    
+    Board->Cells[Cell] |= CELL_REVEALED;
+    if(!(Board->Cells[Cell] & CELL_BOMB)) {
+        --Board->HiddenSafe;
+    }
+    return 1;
+}
+
+// Floods from every empty tile of Starts at once: the hidden ones join the
+// frontier, so floods that meet are walked only once. Stops after Budget
+// tiles were taken off the frontier, and returns 1 if the flood is left
+// unfinished there for the next call. Width and Height are the board's,
+// constants in the sized kernels.
+
+BOARD_INLINE int FloodEmptySized(board* Board, int* Starts, int Count, int Budget, int Width, int Height) {
+    
+    queue* Frontier = &Board->Frontier;
+    int Stride = Width + 2;
+    int Offsets[8] = {-Stride - 1, -Stride, -Stride + 1, -1, 1, Stride - 1, Stride, Stride + 1};
+    
+    // A tile is queued at most once a game, so a frontier with room for
+    // every tile is used as a plain array that never wraps or fills up, and
+    // goes back to its start whenever it runs empty. Boards up to about
+    // 40x40 get one (all three classic sizes), which the sized kernels
+    // know at compile time.
+    
+    if(BoardFrontierCapacity(Width, Height) == Width * Height) {
+        
+        int* Items = Frontier->Items;
+        int Next = Frontier->First;
+        int Length = Frontier->First + Frontier->Length;
+        
+        for(int Index = 0; Index < Count; ++Index) {
+            if(BoardRevealTile(Board, Starts[Index])) {
+                Items[Length++] = Starts[Index];
+                RevealNumbersAroundSized(Board, Starts[Index], Stride);
+            }
+        }
+        
+        for(; Next < Length && Budget > 0; ++Next, --Budget) {
+            for(int Index = 0; Index < 8; ++Index) {
+                int Neighbor = Items[Next] + Offsets[Index];
+                if(CellType(BoardCellValue(Board, Neighbor)) == EMPTY && BoardRevealTile(Board, Neighbor)) {
+                    Items[Length++] = Neighbor;
+                    RevealNumbersAroundSized(Board, Neighbor, Stride);
+                }
+            }
+        }
+        
+        Frontier->First = Next < Length ? Next : 0;
+        Frontier->Length = Length - Next;
+        return Frontier->Length > 0;
+    }
+    
+    int Overflow = Board->FloodOverflow;
+    
+    for(int Index = 0; Index < Count; ++Index) {
+        if(BoardRevealTile(Board, Starts[Index])) {
+            Overflow |= !QueueAdd(Frontier, Starts[Index]);
+            RevealNumbersAroundSized(Board, Starts[Index], Stride);
+        }
+    }
+    
+    // Flood and make visible
+    
+    for(;;) {
+        for(; Frontier->Length > 0 && Budget > 0; --Budget) {
+            int Current = QueuePop(Frontier);
+            
+            for(int Index = 0; Index < 8; ++Index) {
+                int Neighbor = Current + Offsets[Index];
+                if(CellType(BoardCellValue(Board, Neighbor)) == EMPTY && BoardRevealTile(Board, Neighbor)) {
+                    Overflow |= !QueueAdd(Frontier, Neighbor);
+                    
+                    RevealNumbersAroundSized(Board, Neighbor, Stride);
+                }
+            }
+        }
+        
+        if(Frontier->Length > 0 || Budget <= 0) break;
+        
+        // The frontier ran empty with dropped tiles: start a scan for them,
+        // or go on with the one going on. Tiles dropped from here on need
+        // another scan.
+        
+        if(!Board->FloodScan) {
+            if(!Overflow) break;
+            Overflow = 0;
+            Board->FloodScan = 1;
+        }
+        Budget = FloodRequeue(Board, Budget);
+    }
+    
+    Board->FloodOverflow = Overflow;
+    return Frontier->Length > 0 || Overflow || Board->FloodScan;
+}
+
+void FloodEmpty(board* Board, int Start) {
+    FloodEmptyMany(Board, &Start, 1);
+}
+
+// Starts a flood, or adds to the one going on, and runs it for the board's
+// FloodBudget
+
+void FloodEmptyMany(board* Board, int* Starts, int Count) {
+    FloodEmptyBudget(Board, Starts, Count, Board->FloodBudget > 0 ? Board->FloodBudget : INT_MAX);
+}
+
+int FloodEmptyBudget(board* Board, int* Starts, int Count, int Budget) {
+    
+    if(BoardParallel(Board)) {
+        return FloodEmptyParallel(Board, Starts, Count, Budget);
+    }
+    
+    switch(Board->Kernel) {
+        case KERNEL_9X9: return FloodEmptySized(Board, Starts, Count, Budget, 9, 9);
+        case KERNEL_16X16: return FloodEmptySized(Board, Starts, Count, Budget, 16, 16);
+        case KERNEL_30X16: return FloodEmptySized(Board, Starts, Count, Budget, 30, 16);
+        default: return FloodEmptySized(Board, Starts, Count, Budget, Board->Width, Board->Height);
+    }
+}
+
+// Goes on with a flood left unfinished by the budget, called once a frame.
+// The tiles open in the order the flood reaches them, so the opening
+// spreads out from where it was clicked over the frames. Returns 1 while
+// the flood is still unfinished.
+
+int BoardFlood(board* Board, int Budget) {
+    
+    if(!BoardFlooding(Board)) return 0;
+    
+    if(!Board->Playing) {
+        BoardStopFlood(Board);
+        return 0;
+    }
+    
+    int Unfinished = FloodEmptyBudget(Board, NULL, 0, Budget);
+    
+    if(!Unfinished && Board->HiddenSafe == 0) {
+        Board->Playing = 0;
+        Board->Win = 1;
+    }
+    
+    return Unfinished;
+}
+
+int BoardFlooding(board* Board) {
+    return Board->Frontier.Length > 0 || Board->FloodOverflow || Board->FloodScan || Board->Parallel;
+}
+
+// Drops what is left of a flood, for a new game or a lost one
+
+void BoardStopFlood(board* Board) {
+    
+    Board->Frontier.First = 0;
+    Board->Frontier.Length = 0;
+    Board->FloodOverflow = 0;
+    Board->FloodScan = 0;
+    
+    parallelFlood* Flood = Board->Parallel;
+    
+    if(Flood) {
+        for(int Thread = 0; Thread < JOBS_MAX_THREADS; ++Thread) {
+            free(Flood->Threads[Thread].Queue);
+            free(Flood->Threads[Thread].Out);
+        }
+        free(Flood->Pending);
+        free(Flood->Active);
+        free(Flood->Queued);
+        free(Flood);
+        Board->Parallel = NULL;
+    }
+}
+
+// Parallel flood
+//
+// The board is split into its 64x64 chunks, each one row of a plane word
+// per tile row. Chunks with pending tiles run as jobs, a batch at a time:
+// a job reveals them and floods from the empty ones, but only ever reads
+// and writes cells of its own chunk, so the jobs of a batch never touch
+// the same cell. Tiles past its edges are sent back to the caller instead,
+// which marks the hidden ones pending and queues their chunks between
+// batches. The revealed tiles are the same as for the serial flood, a
+// flood reveals the same set in any order. Between calls the chunks still
+// to run are kept in Board->Parallel.
+
+int FloodEmptyParallel(board* Board, int* Starts, int Count, int Budget) {
+    
+    parallelFlood* Flood = Board->Parallel;
+    
+    if(!Flood) {
+        if(Count == 0) return 0;
+        Flood = Board->Parallel = FloodParallelStart(Board);
+    }
+    
+    FloodStitch(Flood, Starts, Count);
+    
+    int Threads = Board->Jobs->ThreadCount;
+    
+    while(Flood->ActiveCount > 0 && Budget > 0) {
+        
+        // A chunk opens at most CHUNK_SIZE^2 tiles, so a batch fits in the
+        // budget, but has a chunk for every thread
+        
+        int Batch = Budget / (CHUNK_SIZE * CHUNK_SIZE);
+        Batch = Batch < Threads ? Threads : Batch;
+        Batch = Batch > Flood->ActiveCount ? Flood->ActiveCount : Batch;
+        
+        JobsRun(Board->Jobs, FloodChunk, Flood, Batch);
+        
+        for(int Index = 0; Index < Batch; ++Index) {
+            Flood->Queued[Flood->Active[Index]] = 0;
+        }
+        Flood->ActiveCount -= Batch;
+        memmove(Flood->Active, &Flood->Active[Batch], Flood->ActiveCount * sizeof(*Flood->Active));
+        
+        for(int Thread = 0; Thread < Threads; ++Thread) {
+            floodThread* Scratch = &Flood->Threads[Thread];
+            FloodStitch(Flood, Scratch->Out, Scratch->OutLength);
+            Board->HiddenSafe -= Scratch->Revealed;
+            Budget -= Scratch->Revealed;
+            Scratch->OutLength = 0;
+            Scratch->Revealed = 0;
+        }
+    }
+    
+    if(Flood->ActiveCount == 0) {
+        BoardStopFlood(Board);
+        return 0;
+    }
+    
+    return 1;
+}
+
+parallelFlood* FloodParallelStart(board* Board) {
+    
+    parallelFlood* Flood = calloc(1, sizeof(*Flood));
+    
+    int ChunksX = (Board->Width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    int ChunksY = (Board->Height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    size_t PlaneWords = (size_t)Board->PlaneStride * (Board->Height + 2);
+    
+    Flood->Board = Board;
+    Flood->ChunksX = ChunksX;
+    Flood->Pending = calloc(PlaneWords, sizeof(*Flood->Pending));
+    Flood->Active = malloc((size_t)ChunksX * ChunksY * sizeof(*Flood->Active));
+    Flood->Queued = calloc((size_t)ChunksX * ChunksY, sizeof(*Flood->Queued));
+    
+    for(int Thread = 0; Thread < Board->Jobs->ThreadCount; ++Thread) {
+        Flood->Threads[Thread].Queue = malloc(CHUNK_SIZE * CHUNK_SIZE * sizeof(int));
+    }
+    
+    return Flood;
+}
+
+// Marks the hidden tiles of Cells pending and queues their chunks
+
+void FloodStitch(parallelFlood* Flood, int* Cells, int Count) {
+    
+    board* Board = Flood->Board;
+    
+    for(int Index = 0; Index < Count; ++Index) {
+        
+        if(Board->Cells[Cells[Index]] & CELL_REVEALED) continue;
+        
+        point Position = BoardCellPosition(Board, Cells[Index]);
+        BoardSetBit(Board, Flood->Pending, Position.X, Position.Y);
+        
+        int Chunk = (Position.Y / CHUNK_SIZE) * Flood->ChunksX + Position.X / CHUNK_SIZE;
+        if(!Flood->Queued[Chunk]) {
+            Flood->Queued[Chunk] = 1;
+            Flood->Active[Flood->ActiveCount++] = Chunk;
+        }
+    }
+}
+
+void FloodSend(floodThread* Thread, int Cell) {
+    if(Thread->OutLength == Thread->OutCapacity) {
+        Thread->OutCapacity = Thread->OutCapacity ? 2 * Thread->OutCapacity : 4096;
+        Thread->Out = realloc(Thread->Out, Thread->OutCapacity * sizeof(*Thread->Out));
+    }
+    Thread->Out[Thread->OutLength++] = Cell;
+}
+
+// One job of a batch: reveals the pending tiles of a chunk and floods the
+// chunk from the empty ones. The queue holds tiles as X + Y * CHUNK_SIZE
+// within the chunk. Tiles around an empty one are never bombs, so every
+// tile revealed here was a hidden safe one.
+
+void FloodChunk(void* Data, int Job, int Thread) {
+    
+    parallelFlood* Flood = (parallelFlood*)Data;
+    board* Board = Flood->Board;
+    floodThread* Scratch = &Flood->Threads[Thread];
+    
+    int Chunk = Flood->Active[Job];
+    int X0 = Chunk % Flood->ChunksX * CHUNK_SIZE;
+    int Y0 = Chunk / Flood->ChunksX * CHUNK_SIZE;
+    int Width = Board->Width - X0 < CHUNK_SIZE ? Board->Width - X0 : CHUNK_SIZE;
+    int Height = Board->Height - Y0 < CHUNK_SIZE ? Board->Height - Y0 : CHUNK_SIZE;
+    int Stride = Board->CellStride;
+    unsigned char* Cells = &Board->Cells[BoardCell(Board, X0, Y0)];
+    
+    // Counting a lazy chunk writes only its own cells too
+    
+    if(Cells[0] == CELL_UNCOUNTED) {
+        BoardCountChunk(Board, X0 / CHUNK_SIZE, Y0 / CHUNK_SIZE);
+    }
+    
+    int* Queue = Scratch->Queue;
+    int Length = 0;
+    int Revealed = 0;
+    
+    for(int Y = 0; Y < Height; ++Y) {
+        
+        unsigned long long* Word = BoardPlaneWord(Board, Flood->Pending, X0, Y0 + Y);
+        
+        for(unsigned long long Bits = *Word; Bits; Bits &= Bits - 1) {
+            int X = CountTrailingZeros(Bits);
+            unsigned char* Cell = &Cells[Y * Stride + X];
+            if(!(*Cell & CELL_REVEALED)) {
+                *Cell |= CELL_REVEALED;
+                ++Revealed;
+                if(CellType(*Cell) == EMPTY) {
+                    Queue[Length++] = Y * CHUNK_SIZE + X;
+                }
+            }
+        }
+        
+        *Word = 0;
+    }
+    
+    for(int Next = 0; Next < Length; ++Next) {
+        
+        int X = Queue[Next] % CHUNK_SIZE;
+        int Y = Queue[Next] / CHUNK_SIZE;
+        
+        for(int NY = Y - 1; NY <= Y + 1; ++NY) {
+            for(int NX = X - 1; NX <= X + 1; ++NX) {
+                
+                if(NX < 0 || NX >= Width || NY < 0 || NY >= Height) {
+                    FloodSend(Scratch, (int)(Cells - Board->Cells) + NY * Stride + NX);
+                    continue;
+                }
+                
+                unsigned char* Cell = &Cells[NY * Stride + NX];
+                if(!(*Cell & CELL_REVEALED)) {
+                    *Cell |= CELL_REVEALED;
+                    ++Revealed;
+                    if(CellType(*Cell) == EMPTY) {
+                        Queue[Length++] = NY * CHUNK_SIZE + NX;
+                    }
+                }
+            }
+        }
+    }
+    
+    Scratch->Revealed += Revealed;
+}
+
+// Goes on with the scan for tiles the frontier dropped when it was full,
+// from cell FloodScan - 1: queues every revealed empty tile that still has
+// a hidden empty neighbor. Stops when the frontier fills up again, to
+// resume there once it ran empty, or after FLOOD_SCAN_CELLS cells for each
+// tile of Budget, so a frame never pays for more of the board than its
+// budget. FloodScan goes back to 0 at the end of the board. Returns what
+// is left of Budget.
+
+int FloodRequeue(board* Board, int Budget) {
+    
+    int Cells = BoardCellCount(Board->Width, Board->Height);
+    int First = Board->FloodScan - 1;
+    long long Limit = First + (long long)Budget * FLOOD_SCAN_CELLS;
+    int End = Limit < Cells ? (int)Limit : Cells;
+    int Cell = First;
+    
+    for(; Cell < End; ++Cell) {
+        
+        // Revealed and empty
+        
+        if((Board->Cells[Cell] & (CELL_REVEALED | CELL_BOMB | CELL_COUNT)) != CELL_REVEALED) continue;
+        
+        int Full = 0;
+        for(int Index = 0; Index < 8; ++Index) {
+            unsigned char Neighbor = BoardCellValue(Board, Cell + Board->Offsets[Index]);
+            if(CellType(Neighbor) == EMPTY && !(Neighbor & CELL_REVEALED)) {
+                Full = !QueueAdd(&Board->Frontier, Cell);
+                break;
+            }
+        }
+        if(Full) break;
+    }
+    
+    Board->FloodScan = Cell < Cells ? Cell + 1 : 0;
+    return Budget - (Cell - First + FLOOD_SCAN_CELLS - 1) / FLOOD_SCAN_CELLS;
+}
+
+// Empty regions
+//
+// Union-find over the cells, with Labels as the parent links. A set's root
+// is always its lowest cell, so a parent comes before its child in row
+// order, and one pass in row order can turn the links into region numbers.
+
+int RegionFind(int* Labels, int Tile) {
+    while(Labels[Tile] != Tile) {
+        Labels[Tile] = Labels[Labels[Tile]];
+        Tile = Labels[Tile];
+    }
+    return Tile;
+}
+
+void RegionUnion(int* Labels, int A, int B) {
+    A = RegionFind(Labels, A);
+    B = RegionFind(Labels, B);
+    if(A < B) {
+        Labels[B] = A;
+    } else if(B < A) {
+        Labels[A] = B;
+    }
+}
+
+// Indexes the board's empty regions after its numbers are known, so that
+// revealing an empty tile is a copy of its region's lists instead of a
+// flood. Once built, new games rebuild it, and added or removed bombs
+// have the next reveal rebuild it. It uses its own memory, about 4 bytes
+// per tile plus the lists, see BoardFreeRegions.
+
+void BoardBuildRegions(board* Board) {
+    
+    BoardFreeRegions(Board);
+    
+    // Regions need every number, so a lazy board counts the rest of them
+    
+    if(Board->LazyNumbers) {
+        CalculateNumbers(Board);
+    }
+    
+    regions* Regions = &Board->Regions;
+    int Stride = Board->CellStride;
+    int Tiles = BoardCellCount(Board->Width, Board->Height);
+    
+    int* Labels = malloc(Tiles * sizeof(*Labels));
+    assert(Labels);
+    
+    // Join each empty tile with the empty tiles before it: left, and the
+    // three above. Tiles above that are next to each other are joined
+    // already, so the one straight above stands for both its sides. Border
+    // cells are labeled -1 like numbers and bombs, and the first cell is
+    // one, so every empty tile has cells on all sides.
+    
+    for(int Tile = 0; Tile < Tiles; ++Tile) {
+        
+        if(Board->Cells[Tile] & (CELL_BOMB | CELL_COUNT)) {
+            Labels[Tile] = -1;
+            continue;
+        }
+        
+        Labels[Tile] = Tile;
+        
+        int Left = Labels[Tile - 1] >= 0;
+        if(Left) {
+            Labels[Tile] = RegionFind(Labels, Tile - 1);
+        }
+        
+        int Above = Tile - Stride;
+        
+        if(Labels[Above] >= 0) {
+            RegionUnion(Labels, Tile, Above);
+        } else {
+            if(!Left && Labels[Above - 1] >= 0) {
+                RegionUnion(Labels, Tile, Above - 1);
+            }
+            if(Labels[Above + 1] >= 0) {
+                RegionUnion(Labels, Tile, Above + 1);
+            }
+        }
+    }
+    
+    // Roots get the next region number, other tiles copy their parent's
+    
+    int Count = 0;
+    for(int Tile = 0; Tile < Tiles; ++Tile) {
+        if(Labels[Tile] == Tile) {
+            Labels[Tile] = Count++;
+        } else if(Labels[Tile] >= 0) {
+            Labels[Tile] = Labels[Labels[Tile]];
+        }
+    }
+    
+    // Cells, counted then placed
+    
+    int* CellStarts = calloc(Count + 1, sizeof(*CellStarts));
+    assert(CellStarts);
+    
+    for(int Tile = 0; Tile < Tiles; ++Tile) {
+        if(Labels[Tile] >= 0) {
+            ++CellStarts[Labels[Tile] + 1];
+        }
+    }
+    for(int Region = 0; Region < Count; ++Region) {
+        CellStarts[Region + 1] += CellStarts[Region];
+    }
+    
+    int* Cells = malloc((CellStarts[Count] + 1) * sizeof(*Cells));
+    assert(Cells);
+    
+    for(int Tile = 0; Tile < Tiles; ++Tile) {
+        if(Labels[Tile] >= 0) {
+            Cells[CellStarts[Labels[Tile]]++] = Tile;
+        }
+    }
+    for(int Region = Count; Region > 0; --Region) {
+        CellStarts[Region] = CellStarts[Region - 1];
+    }
+    CellStarts[0] = 0;
+    
+    // Border, found from each region's cells in turn. Only numbers can be
+    // next to an empty tile, and while a region is listed their labels hold
+    // the last region that listed them as -2 - Region, so each number is
+    // listed once per region. A number can be in up to three lists.
+    
+    int* BorderStarts = malloc((Count + 1) * sizeof(*BorderStarts));
+    int BorderCapacity = CellStarts[Count] + 64;
+    int BorderCount = 0;
+    int* Border = malloc(BorderCapacity * sizeof(*Border));
+    assert(BorderStarts && Border);
+    
+    for(int Region = 0; Region < Count; ++Region) {
+        
+        BorderStarts[Region] = BorderCount;
+        
+        for(int Index = CellStarts[Region]; Index < CellStarts[Region + 1]; ++Index) {
+            for(int Neighbor = 0; Neighbor < 8; ++Neighbor) {
+                
+                int Tile = Cells[Index] + Board->Offsets[Neighbor];
+                if(Labels[Tile] >= 0 || Labels[Tile] == -2 - Region || Board->Cells[Tile] == CELL_BORDER) continue;
+                
+                if(BorderCount == BorderCapacity) {
+                    BorderCapacity *= 2;
+                    Border = realloc(Border, BorderCapacity * sizeof(*Border));
+                    assert(Border);
+                }
+                
+                Labels[Tile] = -2 - Region;
+                Border[BorderCount++] = Tile;
+            }
+        }
+    }
+    BorderStarts[Count] = BorderCount;
+    
+    for(int Index = 0; Index < BorderCount; ++Index) {
+        Labels[Border[Index]] = -1;
+    }
+    
+    Regions->Labels = Labels;
+    Regions->CellStarts = CellStarts;
+    Regions->Cells = Cells;
+    Regions->BorderStarts = BorderStarts;
+    Regions->Border = Border;
+    Regions->Count = Count;
+    Regions->Built = 1;
+}
+
+void BoardFreeRegions(board* Board) {
+    free(Board->Regions.Labels);
+    free(Board->Regions.CellStarts);
+    free(Board->Regions.Cells);
+    free(Board->Regions.BorderStarts);
+    free(Board->Regions.Border);
+    memset(&Board->Regions, 0, sizeof(Board->Regions));
+}
+
+// Reveals what a flood from any tile of the region would
+
+void BoardRevealRegion(board* Board, int Region) {
+    
+    regions* Regions = &Board->Regions;
+    
+    for(int Index = Regions->CellStarts[Region]; Index < Regions->CellStarts[Region + 1]; ++Index) {
+        BoardRevealTile(Board, Regions->Cells[Index]);
+    }
+    for(int Index = Regions->BorderStarts[Region]; Index < Regions->BorderStarts[Region + 1]; ++Index) {
+        BoardRevealTile(Board, Regions->Border[Index]);
+    }
+}
+
+// Neighbor counting
+//
+// Each row is counted a word at a time. The eight neighbor planes of a word
+// are the rows above, at and below it, shifted one bit left and right, and
+// a bit sliced adder sums them into four count bits per tile (Sum[0] holds
+// the ones, Sum[3] the eights). The adder only uses and, or and xor, so the
+// SIMD versions do the same work on 2 or 4 words at once.
+
+BOARD_INLINE void SumNeighbors(unsigned long long* Up, unsigned long long* Row, unsigned long long* Down,
+                               unsigned long long* Sum) {
+    
+    unsigned long long In[8] = {
+        Up[0], (Up[0] << 1) | (Up[-1] >> 63), (Up[0] >> 1) | (Up[1] << 63),
+        (Row[0] << 1) | (Row[-1] >> 63), (Row[0] >> 1) | (Row[1] << 63),
+        Down[0], (Down[0] << 1) | (Down[-1] >> 63), (Down[0] >> 1) | (Down[1] << 63),
+    };
+    
+    // Three full adders and a half adder give the ones and four twos
+    
+    unsigned long long X0 = In[0] ^ In[1], S0 = X0 ^ In[2], C0 = (In[0] & In[1]) | (X0 & In[2]);
+    unsigned long long X1 = In[3] ^ In[4], S1 = X1 ^ In[5], C1 = (In[3] & In[4]) | (X1 & In[5]);
+    unsigned long long S2 = In[6] ^ In[7], C2 = In[6] & In[7];
+    unsigned long long X3 = S0 ^ S1, C3 = (S0 & S1) | (X3 & S2);
+    
+    // Then the twos are summed into twos, fours and eights
+    
+    unsigned long long X4 = C0 ^ C1, T4 = X4 ^ C2, C4 = (C0 & C1) | (X4 & C2);
+    unsigned long long C5 = T4 & C3;
+    
+    Sum[0] = X3 ^ S2;
+    Sum[1] = T4 ^ C3;
+    Sum[2] = C4 ^ C5;
+    Sum[3] = C4 & C5;
+}
+
+#ifdef BOARD_SSE2
+BOARD_INLINE void SumNeighbors2(unsigned long long* Up, unsigned long long* Row, unsigned long long* Down,
+                                unsigned long long* Sum) {
+
+#define LOAD(Pointer) _mm_loadu_si128((__m128i*)(Pointer))
+#define WEST(Pointer) _mm_or_si128(_mm_slli_epi64(LOAD(Pointer), 1), _mm_srli_epi64(LOAD((Pointer) - 1), 63))
+#define EAST(Pointer) _mm_or_si128(_mm_srli_epi64(LOAD(Pointer), 1), _mm_slli_epi64(LOAD((Pointer) + 1), 63))
+    
+    __m128i In[8] = {
+        LOAD(Up), WEST(Up), EAST(Up),
+        WEST(Row), EAST(Row),
+        LOAD(Down), WEST(Down), EAST(Down),
+    };
+
+#undef LOAD
+#undef WEST
+#undef EAST
+    
+    __m128i X0 = _mm_xor_si128(In[0], In[1]), S0 = _mm_xor_si128(X0, In[2]);
+    __m128i C0 = _mm_or_si128(_mm_and_si128(In[0], In[1]), _mm_and_si128(X0, In[2]));
+    __m128i X1 = _mm_xor_si128(In[3], In[4]), S1 = _mm_xor_si128(X1, In[5]);
+    __m128i C1 = _mm_or_si128(_mm_and_si128(In[3], In[4]), _mm_and_si128(X1, In[5]));
+    __m128i S2 = _mm_xor_si128(In[6], In[7]), C2 = _mm_and_si128(In[6], In[7]);
+    __m128i X3 = _mm_xor_si128(S0, S1);
+    __m128i C3 = _mm_or_si128(_mm_and_si128(S0, S1), _mm_and_si128(X3, S2));
+    
+    __m128i X4 = _mm_xor_si128(C0, C1), T4 = _mm_xor_si128(X4, C2);
+    __m128i C4 = _mm_or_si128(_mm_and_si128(C0, C1), _mm_and_si128(X4, C2));
+    __m128i C5 = _mm_and_si128(T4, C3);
+    
+    _mm_storeu_si128((__m128i*)&Sum[0], _mm_xor_si128(X3, S2));
+    _mm_storeu_si128((__m128i*)&Sum[2], _mm_xor_si128(T4, C3));
+    _mm_storeu_si128((__m128i*)&Sum[4], _mm_xor_si128(C4, C5));
+    _mm_storeu_si128((__m128i*)&Sum[6], _mm_and_si128(C4, C5));
+}
+#endif
+
+#ifdef BOARD_AVX2
+BOARD_INLINE void SumNeighbors4(unsigned long long* Up, unsigned long long* Row, unsigned long long* Down,
+                                unsigned long long* Sum) {
+
+#define LOAD(Pointer) _mm256_loadu_si256((__m256i*)(Pointer))
+#define WEST(Pointer) _mm256_or_si256(_mm256_slli_epi64(LOAD(Pointer), 1), _mm256_srli_epi64(LOAD((Pointer) - 1), 63))
+#define EAST(Pointer) _mm256_or_si256(_mm256_srli_epi64(LOAD(Pointer), 1), _mm256_slli_epi64(LOAD((Pointer) + 1), 63))
+    
+    __m256i In[8] = {
+        LOAD(Up), WEST(Up), EAST(Up),
+        WEST(Row), EAST(Row),
+        LOAD(Down), WEST(Down), EAST(Down),
+    };
+
+#undef LOAD
+#undef WEST
+#undef EAST
+    
+    __m256i X0 = _mm256_xor_si256(In[0], In[1]), S0 = _mm256_xor_si256(X0, In[2]);
+    __m256i C0 = _mm256_or_si256(_mm256_and_si256(In[0], In[1]), _mm256_and_si256(X0, In[2]));
+    __m256i X1 = _mm256_xor_si256(In[3], In[4]), S1 = _mm256_xor_si256(X1, In[5]);
+    __m256i C1 = _mm256_or_si256(_mm256_and_si256(In[3], In[4]), _mm256_and_si256(X1, In[5]));
+    __m256i S2 = _mm256_xor_si256(In[6], In[7]), C2 = _mm256_and_si256(In[6], In[7]);
+    __m256i X3 = _mm256_xor_si256(S0, S1);
+    __m256i C3 = _mm256_or_si256(_mm256_and_si256(S0, S1), _mm256_and_si256(X3, S2));
+    
+    __m256i X4 = _mm256_xor_si256(C0, C1), T4 = _mm256_xor_si256(X4, C2);
+    __m256i C4 = _mm256_or_si256(_mm256_and_si256(C0, C1), _mm256_and_si256(X4, C2));
+    __m256i C5 = _mm256_and_si256(T4, C3);
+    
+    _mm256_storeu_si256((__m256i*)&Sum[0], _mm256_xor_si256(X3, S2));
+    _mm256_storeu_si256((__m256i*)&Sum[4], _mm256_xor_si256(T4, C3));
+    _mm256_storeu_si256((__m256i*)&Sum[8], _mm256_xor_si256(C4, C5));
+    _mm256_storeu_si256((__m256i*)&Sum[12], _mm256_and_si256(C4, C5));
+}
+#endif
+
+// Moves bit N of the low byte to the low bit of byte N. The byte is copied
+// to all eight bytes, byte N keeps only bit N, and adding 0x7F per byte
+// carries a set bit into the top of its byte without touching the next.
+
+BOARD_INLINE unsigned long long SpreadBits(unsigned long long Bits) {
+    unsigned long long Copies = ((Bits & 0xFF) * 0x0101010101010101ull) & 0x8040201008040201ull;
+    return ((Copies + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull;
+}
+
+// Writes the numbers and bomb bits of Count (at most 64) cells from one
+// word of count bits and one of bombs, eight cells at a time, keeping the
+// cells' other bits. Assumes a little endian target, like every one this
+// game runs on.
+
+BOARD_INLINE void WriteCells(unsigned char* Cells, int Count, unsigned long long* Sum, unsigned long long Bombs) {
+    
+    unsigned long long Keep = 0x0101010101010101ull * (CELL_REVEALED | CELL_FLAGGED | CELL_HIT);
+    
+    for(int Bit = 0; Bit < Count; Bit += 8) {
+        unsigned long long Eight =
+            SpreadBits(Sum[0] >> Bit) |
+            SpreadBits(Sum[1] >> Bit) << 1 |
+            SpreadBits(Sum[2] >> Bit) << 2 |
+            SpreadBits(Sum[3] >> Bit) << 3 |
+            SpreadBits(Bombs >> Bit) << 4;
+        unsigned long long Old = 0;
+        if(Count - Bit >= 8) {
+            memcpy(&Old, &Cells[Bit], 8);
+            Eight |= Old & Keep;
+            memcpy(&Cells[Bit], &Eight, 8);
+        } else {
+            memcpy(&Old, &Cells[Bit], Count - Bit);
+            Eight |= Old & Keep;
+            memcpy(&Cells[Bit], &Eight, Count - Bit);
+        }
+    }
+}
+
+// Bombs count as zero, so each lane's count bits are masked with its row.
+// Width is the board's, a constant in the sized kernels.
+
+BOARD_INLINE void CalculateNumbersRowSized(board* Board, int Y, int Width) {
+    
+    int RowWords = (Width + 63) / 64;
+    int PlaneStride = RowWords + 2;
+    unsigned long long* Up = &Board->Bombs[Y * PlaneStride + 1];
+    unsigned long long* Row = Up + PlaneStride;
+    unsigned long long* Down = Row + PlaneStride;
+    unsigned char* Cells = &Board->Cells[(Y + 1) * (Width + 2) + 1];
+    
+    unsigned long long Sum[16];
+    unsigned long long Lane[4];
+    int Word = 0;
+    int Lanes = 1;
+    
+    while(Word < RowWords) {
+
+#ifdef BOARD_AVX2
+        if(Word + 4 <= RowWords) {
+            SumNeighbors4(&Up[Word], &Row[Word], &Down[Word], Sum);
+            Lanes = 4;
+        } else
+#endif
+#ifdef BOARD_SSE2
+        if(Word + 2 <= RowWords) {
+            SumNeighbors2(&Up[Word], &Row[Word], &Down[Word], Sum);
+            Lanes = 2;
+        } else
+#endif
+        {
+            SumNeighbors(&Up[Word], &Row[Word], &Down[Word], Sum);
+            Lanes = 1;
+        }
+        
+        for(int Index = 0; Index < Lanes; ++Index, ++Word) {
+            for(int Bit = 0; Bit < 4; ++Bit) {
+                Lane[Bit] = Sum[Bit * Lanes + Index] & ~Row[Word];
+            }
+            int Count = Width - Word * 64;
+            WriteCells(&Cells[Word * 64], Count < 64 ? Count : 64, Lane, Row[Word]);
+        }
+    }
+}
+
+void CalculateNumbersRow(board* Board, int Y) {
+    CalculateNumbersRowSized(Board, Y, Board->Width);
+}
+
+// Boards one word wide, like all the classic sizes, slide a window of
+// three rows down the plane instead, so each row word is read once and the
+// empty words at their sides are zeros the compiler can drop.
+
+BOARD_INLINE void CalculateNumbersSized(board* Board, int Width, int Height) {
+    
+    if(Width > 64) {
+        for(int Y = 0; Y < Height; ++Y) {
+            CalculateNumbersRowSized(Board, Y, Width);
+        }
+        return;
+    }
+    
+    int PlaneStride = 3;
+    unsigned long long* Bombs = &Board->Bombs[1];
+    unsigned long long Window[3][3] = {{0, Bombs[0], 0}, {0, Bombs[PlaneStride], 0}, {0}};
+    unsigned long long Sum[4];
+    
+    for(int Y = 0; Y < Height; ++Y) {
+        Window[2][1] = Bombs[(Y + 2) * PlaneStride];
+        SumNeighbors(&Window[0][1], &Window[1][1], &Window[2][1], Sum);
+        for(int Bit = 0; Bit < 4; ++Bit) {
+            Sum[Bit] &= ~Window[1][1];
+        }
+        WriteCells(&Board->Cells[(Y + 1) * (Width + 2) + 1], Width, Sum, Window[1][1]);
+        Window[0][1] = Window[1][1];
+        Window[1][1] = Window[2][1];
+    }
+}
+
+void CalculateNumbers(board* Board) {
+    
+    if(BoardParallel(Board)) {
+        JobsRun(Board->Jobs, CalculateNumbersBand, Board, BoardBands(Board));
+        return;
+    }
+    
+    switch(Board->Kernel) {
+        case KERNEL_9X9: CalculateNumbersSized(Board, 9, 9); break;
+        case KERNEL_16X16: CalculateNumbersSized(Board, 16, 16); break;
+        case KERNEL_30X16: CalculateNumbersSized(Board, 30, 16); break;
+        default: CalculateNumbersSized(Board, Board->Width, Board->Height); break;
+    }
+}
+
+// CalculateNumbersRow for one word of each of the chunk's rows
+
+void BoardCountChunk(board* Board, int ChunkX, int ChunkY) {
+    
+    int X0 = ChunkX * CHUNK_SIZE;
+    int Y0 = ChunkY * CHUNK_SIZE;
+    int Width = Board->Width - X0 < CHUNK_SIZE ? Board->Width - X0 : CHUNK_SIZE;
+    int Height = Board->Height - Y0 < CHUNK_SIZE ? Board->Height - Y0 : CHUNK_SIZE;
+    
+    for(int Y = Y0; Y < Y0 + Height; ++Y) {
+        
+        unsigned long long* Row = BoardPlaneWord(Board, Board->Bombs, X0, Y);
+        unsigned long long Sum[4];
+        
+        SumNeighbors(Row - Board->PlaneStride, Row, Row + Board->PlaneStride, Sum);
+        for(int Bit = 0; Bit < 4; ++Bit) {
+            Sum[Bit] &= ~*Row;
+        }
+        WriteCells(&Board->Cells[BoardCell(Board, X0, Y)], Width, Sum, *Row);
+    }
+}
+
+// A job of CalculateNumbers on a large board. A band reads the bomb rows
+// above and below it too, but writes the cells of its own rows only, and
+// every row is counted by the same code as on one thread.
+
+void CalculateNumbersBand(void* Data, int Band, int Thread) {
+    
+    (void)Thread;
+    board* Board = (board*)Data;
+    int End = (Band + 1) * CHUNK_SIZE < Board->Height ? (Band + 1) * CHUNK_SIZE : Board->Height;
+    
+    for(int Y = Band * CHUNK_SIZE; Y < End; ++Y) {
+        CalculateNumbersRow(Board, Y);
+    }
+}
+
+int BoardParallel(board* Board) {
+    return Board->Jobs && (long long)Board->Width * Board->Height >= PARALLEL_TILES;
+}
+
+// Large boards are generated on the job pool in bands of CHUNK_SIZE rows,
+// each one row of chunks
+
+int BoardBands(board* Board) {
+    return (Board->Height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+}
+
+// Index of the tile that is the Nth (from 0) tile without a bomb
+
+int BoardNthSafeTile(board* Board, int N) {
+    for(int Y = 0; Y < Board->Height; ++Y) {
+        for(int Word = 0; Word < Board->RowWords; ++Word) {
+            unsigned long long Safe = ~*BoardPlaneWord(Board, Board->Bombs, Word * 64, Y) & BoardRowMask(Board, Word);
+            int Count = CountBits(Safe);
+            if(N < Count) {
+                for(; N > 0; --N) {
+                    Safe &= Safe - 1;
+                }
+                return Y * Board->Width + Word * 64 + CountTrailingZeros(Safe);
+            }
+            N -= Count;
+        }
+    }
+    assert(0);
+    return -1;
+}
+
+// Bombs are generated chunk by chunk, and a chunk's bombs depend only on
+// the seed, the chunk's coordinates and the board's size and bomb count,
+// so any chunk can be made on its own, in any order or on any thread.
+// Chunks are numbered row by row, and each gets the share of bombs its
+// free tiles are of all free tiles, rounded so the shares add up to
+// exactly Bombs. Excluded is a sorted list of tile indices, meant to be
+// small like the first pick's area, and the Bombs plane must be empty.
+
+void PlaceBombs(board* Board, int Bombs, int* Excluded, int ExcludedCount) {
+    
+    assert(Bombs >= 0 && Bombs <= Board->Width * Board->Height - ExcludedCount);
+    
+    if(BoardParallel(Board)) {
+        bombPlacement Placement = {Board, Bombs, Excluded, ExcludedCount};
+        JobsRun(Board->Jobs, PlaceBombsBand, &Placement, BoardBands(Board));
+        return;
+    }
+    
+    for(int ChunkY = 0; ChunkY * CHUNK_SIZE < Board->Height; ++ChunkY) {
+        for(int ChunkX = 0; ChunkX * CHUNK_SIZE < Board->Width; ++ChunkX) {
+            PlaceChunkBombs(Board, ChunkX, ChunkY, Bombs, Excluded, ExcludedCount);
+        }
+    }
+}
+
+// A job of PlaceBombs on a large board, one row of chunks. Chunks are
+// placed on their own anyway, see PlaceChunkBombs.
+
+void PlaceBombsBand(void* Data, int Band, int Thread) {
+    (void)Thread;
+    bombPlacement* Placement = (bombPlacement*)Data;
+    board* Board = Placement->Board;
+    for(int ChunkX = 0; ChunkX * CHUNK_SIZE < Board->Width; ++ChunkX) {
+        PlaceChunkBombs(Board, ChunkX, Band, Placement->Bombs, Placement->Excluded, Placement->ExcludedCount);
+    }
+}
+
+unsigned long long ChunkKey(int ChunkX, int ChunkY) {
+    return (unsigned int)ChunkX | (unsigned long long)(unsigned int)ChunkY << 32;
+}
+
+// Free tiles in all chunks numbered before this one
+
+long long ChunkFreeTilesBefore(board* Board, int ChunkX, int ChunkY, int* Excluded, int ExcludedCount) {
+    
+    long long Y0 = (long long)ChunkY * CHUNK_SIZE;
+    long long X0 = (long long)ChunkX * CHUNK_SIZE;
+    
+    if(Y0 >= Board->Height) {
+        return (long long)Board->Width * Board->Height - ExcludedCount;
+    }
+    
+    long long RowHeight = Board->Height - Y0 < CHUNK_SIZE ? Board->Height - Y0 : CHUNK_SIZE;
+    long long Tiles = Y0 * Board->Width + X0 * RowHeight;
+    
+    for(int Index = 0; Index < ExcludedCount; ++Index) {
+        int X = Excluded[Index] % Board->Width / CHUNK_SIZE;
+        int Y = Excluded[Index] / Board->Width / CHUNK_SIZE;
+        if(Y < ChunkY || (Y == ChunkY && X < ChunkX)) {
+            --Tiles;
+        }
+    }
+    
+    return Tiles;
+}
+
+// Rounds the running total of shares, not each share, so no bomb is lost
+
+int ChunkBombQuota(board* Board, int ChunkX, int ChunkY, int Bombs, int* Excluded, int ExcludedCount) {
+    
+    long long Free = (long long)Board->Width * Board->Height - ExcludedCount;
+    if(Free == 0) return 0;
+    
+    int NextX = ChunkX + 1;
+    int NextY = ChunkY;
+    if(NextX * CHUNK_SIZE >= Board->Width) {
+        NextX = 0;
+        ++NextY;
+    }
+    
+    long long Start = ChunkFreeTilesBefore(Board, ChunkX, ChunkY, Excluded, ExcludedCount);
+    long long End = ChunkFreeTilesBefore(Board, NextX, NextY, Excluded, ExcludedCount);
+    
+    return (int)(Bombs * End / Free - Bombs * Start / Free);
+}
+
+// Index within the chunk of its Rank-th (from 0) free tile. Excluded tiles
+// in the chunk come in the same order as the chunk's own tiles.
+
+int ChunkRankToTile(board* Board, int X0, int Y0, int Width, int Height, int Rank, int* Excluded, int ExcludedCount) {
+    for(int Index = 0; Index < ExcludedCount; ++Index) {
+        int X = Excluded[Index] % Board->Width - X0;
+        int Y = Excluded[Index] / Board->Width - Y0;
+        if(X >= 0 && Y >= 0 && X < Width && Y < Height) {
+            if(Y * Width + X > Rank) break;
+            ++Rank;
+        }
+    }
+    return Rank;
+}
+
+// Places one chunk's quota with Floyd's sampling over the ranks of its
+// free tiles: for each J of the last Bombs ranks, a random rank up to J is
+// taken, or J itself if that one already is. The plane is the set of taken
+// ranks, so every bomb costs one random number. Past half the free tiles
+// it is cheaper to fill the chunk and take away the safe tiles the same
+// way. The random numbers come from the seed hashed with the chunk's
+// coordinates, never from the board's own generator.
+
+void PlaceChunkBombs(board* Board, int ChunkX, int ChunkY, int Bombs, int* Excluded, int ExcludedCount) {
+    
+    int X0 = ChunkX * CHUNK_SIZE;
+    int Y0 = ChunkY * CHUNK_SIZE;
+    int Width = Board->Width - X0 < CHUNK_SIZE ? Board->Width - X0 : CHUNK_SIZE;
+    int Height = Board->Height - Y0 < CHUNK_SIZE ? Board->Height - Y0 : CHUNK_SIZE;
+    
+    int Free = Width * Height;
+    for(int Index = 0; Index < ExcludedCount; ++Index) {
+        int X = Excluded[Index] % Board->Width - X0;
+        int Y = Excluded[Index] / Board->Width - Y0;
+        if(X >= 0 && Y >= 0 && X < Width && Y < Height) {
+            --Free;
+        }
+    }
+    
+    int Quota = ChunkBombQuota(Board, ChunkX, ChunkY, Bombs, Excluded, ExcludedCount);
+    
+    // Most chunks have no excluded tiles to skip over
+    
+    if(Free == Width * Height) {
+        ExcludedCount = 0;
+    }
+    
+    int Invert = Quota > Free / 2;
+    int Picks = Invert ? Free - Quota : Quota;
+    
+    rng Random;
+    RngSeed(&Random, RngHash(Board->Seed, ChunkKey(ChunkX, ChunkY)));
+    
+    if(Invert) {
+        for(int Y = 0; Y < Height; ++Y) {
+            *BoardPlaneWord(Board, Board->Bombs, X0, Y0 + Y) = BoardRowMask(Board, ChunkX);
+        }
+        for(int Index = 0; Index < ExcludedCount; ++Index) {
+            int X = Excluded[Index] % Board->Width;
+            int Y = Excluded[Index] / Board->Width;
+            if(X - X0 >= 0 && Y - Y0 >= 0 && X - X0 < Width && Y - Y0 < Height) {
+                BoardClearBit(Board, Board->Bombs, X, Y);
+            }
+        }
+    }
+    
+    // A rank is taken when its bit no longer matches the starting chunk
+    
+    for(int J = Free - Picks; J < Free; ++J) {
+        int Tile = ChunkRankToTile(Board, X0, Y0, Width, Height, RngBelow(&Random, J + 1), Excluded, ExcludedCount);
+        if(BoardGetBit(Board, Board->Bombs, X0 + Tile % Width, Y0 + Tile / Width) != Invert) {
+            Tile = ChunkRankToTile(Board, X0, Y0, Width, Height, J, Excluded, ExcludedCount);
+        }
+        BoardFlipBit(Board, Board->Bombs, X0 + Tile % Width, Y0 + Tile / Width);
+    }
+}
+
+// Per chunk density mode, for boards too big to have a bomb count: each
+// tile is a bomb with probability Density / 2^32 on its own, so counts are
+// only right on average and two chunks may differ by more than one. Rows
+// gets the chunk's CHUNK_SIZE rows, bit X of word Y being tile X, Y.
+
+void ChunkBombsByDensity(unsigned long long Seed, int ChunkX, int ChunkY, unsigned int Density, unsigned long long* Rows) {
+    
+    rng Random;
+    RngSeed(&Random, RngHash(Seed, ChunkKey(ChunkX, ChunkY)));
+    
+    for(int Y = 0; Y < CHUNK_SIZE; ++Y) {
+        unsigned long long Row = 0;
+        for(int X = 0; X < CHUNK_SIZE; X += 2) {
+            unsigned long long Bits = RngNext(&Random);
+            Row |= (unsigned long long)((unsigned int)Bits < Density) << X;
+            Row |= (unsigned long long)((unsigned int)(Bits >> 32) < Density) << (X + 1);
+        }
+        Rows[Y] = Row;
+    }
+}
+
+// Moves the bomb at X, Y to a random tile without one. It stays in place
+// while the new tile is picked, so it can't land where it was. A few
+// random tiles are tried before counting through the plane, which only
+// dense boards get to. Only the numbers around the two tiles change.
+
+void MoveBomb(board* Board, int X, int Y) {
+    
+    int Tiles = Board->Width * Board->Height;
+    int Tile = -1;
+    
+    for(int Try = 0; Try < 16 && Tile < 0; ++Try) {
+        int Candidate = RngBelow(&Board->Random, Tiles);
+        if(!BoardGetBit(Board, Board->Bombs, Candidate % Board->Width, Candidate / Board->Width)) {
+            Tile = Candidate;
+        }
+    }
+    
+    if(Tile < 0) {
+        Tile = BoardNthSafeTile(Board, RngBelow(&Board->Random, Tiles - Board->BombCount));
+    }
+    
+    BoardAddBomb(Board, Tile % Board->Width, Tile / Board->Width);
+    BoardRemoveBomb(Board, X, Y);
+}
+
+// Adds Amount to the numbers of the tiles around X, Y that aren't bombs.
+// Border cells have the bomb bit, so they are left alone too.
+
+void BoardAddToNumbers(board* Board, int X, int Y, int Amount) {
+    int Cell = BoardCell(Board, X, Y);
+    for(int Index = 0; Index < 8; ++Index) {
+        int Neighbor = Cell + Board->Offsets[Index];
+        if(!(Board->Cells[Neighbor] & CELL_BOMB)) {
+            Board->Cells[Neighbor] += Amount;
+        }
+    }
+}
+
+// Bombs can be added and removed one at a time, for editors and for solvers
+// trying out bombs, and only the 3x3 area around each is counted again.
+// The bomb count and flags left change with them. A built region index is
+// rebuilt on the next reveal.
+
+void BoardAddBomb(board* Board, int X, int Y) {
+    
+    if(BoardGetBit(Board, Board->Bombs, X, Y)) return;
+    
+    unsigned char* Cell = &Board->Cells[BoardCell(Board, X, Y)];
+    BoardCountAround(Board, BoardCell(Board, X, Y));
+    
+    BoardSetBit(Board, Board->Bombs, X, Y);
+    *Cell = (*Cell & ~CELL_COUNT) | CELL_BOMB;
+    BoardAddToNumbers(Board, X, Y, 1);
+    
+    if(!(*Cell & CELL_REVEALED)) {
+        --Board->HiddenSafe;
+    }
+    ++Board->BombCount;
+    ++Board->Flags;
+    Board->Regions.Stale = Board->Regions.Built;
+}
+
+void BoardRemoveBomb(board* Board, int X, int Y) {
+    
+    if(!BoardGetBit(Board, Board->Bombs, X, Y)) return;
+    
+    unsigned char* Cell = &Board->Cells[BoardCell(Board, X, Y)];
+    BoardCountAround(Board, BoardCell(Board, X, Y));
+    
+    BoardClearBit(Board, Board->Bombs, X, Y);
+    *Cell &= ~CELL_BOMB;
+    BoardAddToNumbers(Board, X, Y, -1);
+    *Cell |= BoardCountNeighbors(Board, BoardCell(Board, X, Y), BOMB);
+    
+    if(!(*Cell & CELL_REVEALED)) {
+        ++Board->HiddenSafe;
+    }
+    --Board->BombCount;
+    --Board->Flags;
+    Board->Regions.Stale = Board->Regions.Built;
+}
+
+// The same size, bomb count and seed always give the same board, and the
+// same first reveal too with SafeOpening
+
+void BoardNewGame(board* Board, int Bombs, unsigned long long Seed) {
+    
+    assert(Bombs >= 0 && Bombs < Board->Width * Board->Height);
+    
+    size_t PlaneWords = (size_t)Board->PlaneStride * (Board->Height + 2);
+    
+    memset(Board->Bombs, 0, PlaneWords * sizeof(*Board->Bombs));
+    memset(Board->Cells, Board->LazyNumbers ? CELL_UNCOUNTED : 0, BoardCellCount(Board->Width, Board->Height));
+    BoardSetBorder(Board);
+    BoardStopFlood(Board);
+    
+    RngSeed(&Board->Random, Seed);
+    Board->Seed = Seed;
+    
+    Board->BombCount = Bombs;
+    Board->HiddenSafe = Board->Width * Board->Height - Bombs;
+    Board->Flags = Bombs;
+    Board->Playing = 1;
+    Board->FirstPick = 1;
+    Board->Win = 0;
+    
+    if(Board->SafeOpening) return;
+    
+    // Bombs
+    
+    PlaceBombs(Board, Bombs, NULL, 0);
+    
+    // Numbers, or later chunk by chunk as they are needed
+    
+    if(!Board->LazyNumbers) {
+        CalculateNumbers(Board);
+    }
+    
+    if(Board->Regions.Built) {
+        BoardBuildRegions(Board);
+    }
+}
+
+// Places the bombs of a SafeOpening game at its first reveal, none on Cell
+// or around it, so Cell is empty and floods. A board too full for that
+// only keeps Cell free. Flags put down before are kept: an eager board is
+// counted whole, and a lazy one counts again the chunks it counted before
+// there were bombs.
+
+void BoardPlaceOpening(board* Board, int Cell) {
+    
+    point Position = BoardCellPosition(Board, Cell);
+    int Excluded[9];
+    int ExcludedCount = 0;
+    
+    for(int Y = Position.Y - 1; Y <= Position.Y + 1; ++Y) {
+        for(int X = Position.X - 1; X <= Position.X + 1; ++X) {
+            if(BoardContains(Board, X, Y)) {
+                Excluded[ExcludedCount++] = Y * Board->Width + X;
+            }
+        }
+    }
+    
+    if(Board->BombCount > Board->Width * Board->Height - ExcludedCount) {
+        Excluded[0] = Position.Y * Board->Width + Position.X;
+        ExcludedCount = 1;
+    }
+    
+    PlaceBombs(Board, Board->BombCount, Excluded, ExcludedCount);
+    
+    if(!Board->LazyNumbers) {
+        CalculateNumbers(Board);
+    } else {
+        for(int ChunkY = 0; ChunkY * CHUNK_SIZE < Board->Height; ++ChunkY) {
+            for(int ChunkX = 0; ChunkX * CHUNK_SIZE < Board->Width; ++ChunkX) {
+                if(Board->Cells[BoardCell(Board, ChunkX * CHUNK_SIZE, ChunkY * CHUNK_SIZE)] != CELL_UNCOUNTED) {
+                    BoardCountChunk(Board, ChunkX, ChunkY);
+                }
+            }
+        }
+    }
+    
+    Board->Regions.Stale = Board->Regions.Built;
+}
+
+// Reveals the empty tiles of Starts and everything a flood from them
+// would, from the region index when there is one
+
+void BoardOpenEmpty(board* Board, int* Starts, int Count) {
+    
+    if(Board->Regions.Stale) {
+        BoardBuildRegions(Board);
+    }
+    
+    if(!Board->Regions.Built) {
+        FloodEmptyMany(Board, Starts, Count);
+        return;
+    }
+    
+    // A start that is revealed by now is in a region listed already
+    
+    for(int Index = 0; Index < Count; ++Index) {
+        if(!(Board->Cells[Starts[Index]] & CELL_REVEALED)) {
+            BoardRevealRegion(Board, Board->Regions.Labels[Starts[Index]]);
+        }
+    }
+}
+
+// Left click on a tile
+
+void BoardReveal(board* Board, int X, int Y) {
+    if(BoardContains(Board, X, Y)) {
+        BoardRevealCell(Board, BoardCell(Board, X, Y));
+    }
+}
+
+void BoardRevealCell(board* Board, int Cell) {
+    
+    if(!Board->Playing || (BoardCellValue(Board, Cell) & CELL_FLAGGED)) return;
+    
+    if(Board->FirstPick && Board->SafeOpening) {
+        BoardPlaceOpening(Board, Cell);
+    }
+    
+    int Type = CellType(Board->Cells[Cell]);
+    
+    // Relocate bomb if hit with first pick
+    
+    if(Type == BOMB && Board->FirstPick) {
+        point Position = BoardCellPosition(Board, Cell);
+        MoveBomb(Board, Position.X, Position.Y);
+        Type = CellType(Board->Cells[Cell]);
+    }
+    
+    if(Type == EMPTY) {
+        BoardOpenEmpty(Board, &Cell, 1);
+    } else {
+        BoardRevealTile(Board, Cell);
+        if(Type == BOMB) {
+            Board->Playing = 0;
+            Board->Win = 0;
+            Board->Cells[Cell] |= CELL_HIT;
+        }
+    }
+    
+    Board->FirstPick = 0;
+    
+    // Won once no safe tile is hidden. A finished game shows every tile,
+    // see BoardGetTile.
+    
+    if(Board->Playing && Board->HiddenSafe == 0) {
+        Board->Playing = 0;
+        Board->Win = 1;
+    }
+}
+
+// Right click on a tile
+
+void BoardFlag(board* Board, int X, int Y) {
+    
+    if(!Board->Playing || !BoardContains(Board, X, Y)) return;
+    
+    unsigned char* Cell = &Board->Cells[BoardCell(Board, X, Y)];
+    BoardCellValue(Board, BoardCell(Board, X, Y));
+    
+    if(*Cell & CELL_FLAGGED) {
+        *Cell &= ~CELL_FLAGGED;
+        ++Board->Flags;
+    } else if(!(*Cell & CELL_REVEALED) && Board->Flags > 0) {
+        *Cell |= CELL_FLAGGED;
+        --Board->Flags;
+    }
+}
+
+// Reveal the hidden neighbors of a number whose bombs are all flagged, in
+// one go: a wrong flag loses at once, numbers are revealed and all the
+// empty neighbors are opened together, see BoardOpenEmpty
+
+void BoardChord(board* Board, int X, int Y) {
+    
+    if(!Board->Playing || !BoardContains(Board, X, Y)) return;
+    
+    int Cell = BoardCell(Board, X, Y);
+    BoardCountAround(Board, Cell);
+    
+    if(!(Board->Cells[Cell] & CELL_REVEALED) || CellType(Board->Cells[Cell]) != NUMBER) return;
+    
+    int Flagged = 0;
+    for(int Index = 0; Index < 8; ++Index) {
+        Flagged += (Board->Cells[Cell + Board->Offsets[Index]] & CELL_FLAGGED) != 0;
+    }
+    
+    if(Flagged != (Board->Cells[Cell] & CELL_COUNT)) return;
+    
+    int Empty[8];
+    int EmptyCount = 0;
+    
+    for(int Index = 0; Index < 8; ++Index) {
+        
+        int Neighbor = Cell + Board->Offsets[Index];
+        if(Board->Cells[Neighbor] & (CELL_REVEALED | CELL_FLAGGED)) continue;
+        
+        int Type = CellType(Board->Cells[Neighbor]);
+        
+        if(Type == BOMB) {
+            BoardRevealTile(Board, Neighbor);
+            Board->Cells[Neighbor] |= CELL_HIT;
+            Board->Playing = 0;
+            Board->Win = 0;
+            return;
+        }
+        
+        if(Type == EMPTY) {
+            Empty[EmptyCount++] = Neighbor;
+        }
+    }
+    
+    for(int Index = 0; Index < 8; ++Index) {
+        int Neighbor = Cell + Board->Offsets[Index];
+        if(CellType(Board->Cells[Neighbor]) == NUMBER && !(Board->Cells[Neighbor] & CELL_FLAGGED)) {
+            BoardRevealTile(Board, Neighbor);
+        }
+    }
+    
+    BoardOpenEmpty(Board, Empty, EmptyCount);
+    
+    if(Board->HiddenSafe == 0) {
+        Board->Playing = 0;
+        Board->Win = 1;
+    }
+}
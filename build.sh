@@ -0,0 +1,8 @@
+#!/bin/sh
+# Headless build of the game core benchmark, no Win32/D3D needed
+# CFLAGS=-mavx2 ./build.sh counts neighbors four words at a time
+# CFLAGS=-fsanitize=thread ./build.sh && ./bench check runs the checks
+# under ThreadSanitizer, which exits non-zero on a race
+cc bench.c \
+-o bench -O2 -g \
+-lm -pthread $CFLAGS
@@ -14,13 +14,12 @@
 #include <float.h>
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
+#include "maths.h"
+#include "pick.h"
 
 // Types
 
-typedef struct { float X, Y, Z; } v3;
 typedef struct { float R, G, B, A; } color;
-typedef struct { float M[4][4]; } matrix;
-typedef struct { v3 A, B, C; } triangle;
 
 typedef struct {
     unsigned char* Data;
@@ -34,6 +33,7 @@ typedef struct {
     int NumVertices;
     int Stride;
     int Offset;
+    pickMesh Pick;
 } mesh;
 
 typedef struct {
@@ -45,8 +45,6 @@ typedef struct {
 
 typedef struct {
     matrix Model;
-    matrix View;
-    matrix Projection;
     color Color;
     float UOffset;
     float VOffset;
@@ -54,6 +52,13 @@ typedef struct {
     float Padding1;
 } constants;
 
+// Constants that only change with the camera, in their own buffer so a
+// draw uploads just its model and color
+
+typedef struct {
+    matrix ViewProjection;
+} frameConstants;
+
 typedef struct {
     LARGE_INTEGER StartingCount;
     LARGE_INTEGER EndingCount;
@@ -65,6 +70,7 @@ typedef struct {
 typedef struct {
     int X;
     int Y;
+    int Inside;
     int LeftButtonPressed;
     int RightButtonPressed;
     int MiddleButtonDown;
@@ -72,10 +78,34 @@ typedef struct {
     int WheelDown;
 } mouse;
 
+// The matrices are for the Position, depth range and client size they
+// were built with, and CameraUpdate rebuilds them only when one of those
+// changes.
+// Version counts the rebuilds, so copies of the matrices can tell when
+// they are stale.
+
 typedef struct {
     v3 Position;
     float DragSensitivity;
     float Speed;
+    float Near;
+    float Far;
+    float Height;
+    
+    matrix View;
+    matrix Projection;
+    matrix ViewProjection;
+    matrix InverseView;
+    matrix InverseProjection;
+    matrix InverseViewProjection;
+    plane Frustum[PLANE_COUNT];
+    
+    v3 BuiltPosition;
+    float BuiltNear;
+    float BuiltFar;
+    int BuiltWidth;
+    int BuiltHeight;
+    int Version;
 } camera;
 
 typedef struct {
@@ -103,6 +133,9 @@ camera Camera = {
     .Position = {4.0f, 5.0f, -14.0f},
     .DragSensitivity = 0.1f,
     .Speed = 20.0f,
+    .Near = 1.0f,
+    .Far = 100.0f,
+    .Height = 1.0f,
 };
 
 mouse Mouse;
@@ -140,14 +173,12 @@ ID3D11Device1* Device;
 ID3D11DeviceContext1* Context;
 ID3D11Buffer* Buffer;
 ID3D11Buffer* ConstantBuffer;
+ID3D11Buffer* FrameConstantBuffer;
 
 ID3D11VertexShader* VertexShader;
 ID3D11PixelShader* PixelShader;
 ID3D11InputLayout* InputLayout;
 
-matrix ProjectionMatrix;
-matrix ViewMatrix;
-
 // Declarations
 
 void Init();
@@ -160,29 +191,8 @@ void Draw();
 MemoryInit(size_t Size);
 void* MemoryAlloc(size_t Size);
 
-// vector & matrix
-
-v3 V3Add(v3 A, v3 B);
-v3 V3Subtract(v3 A, v3 B);
-v3 V3CrossProduct(v3 A, v3 B);
-v3 V3AddScalar(v3 A, float B);
-v3 V3MultiplyScalar(v3 A, float B);
-
-float V3DotProduct(v3 A, v3 B);
-float V3Length(v3* V);
-
-int V3IsZero(v3 Vector);
-int v3Compare(v3 A, v3 B);
-
-void V3Normalize(v3* V);
-
-v3 V3TransformCoord(v3* V, matrix* M);
-v3 V3TransformNormal(v3* V, matrix* M);
-
-matrix MatrixTranslation(v3 V);
-matrix MatrixMultiply(matrix* A, matrix* B);
-
-void MatrixInverse(matrix* Source, matrix* Target);
+memory MemoryCreate(size_t Size);
+void* MemoryArenaAlloc(memory* Arena, size_t Size);
 
 // other
 
@@ -195,8 +205,12 @@ void GridInit(grid* Grid);
 void GridDraw(grid* Grid);
 
 mesh CreateMesh(float* Vertices, size_t Size, int Stride, int Offset);
-int PickMeshRectangle(int MouseX, int MouseY, v3 Position, mesh* Mesh);
-int RayTriangleIntersect(v3 RayOrigin, v3 RayDirection, triangle* Triangle);
+void CreatePickMesh(mesh* Mesh);
+int CameraUpdate();
+int CameraBoxVisible(v3 Min, v3 Max);
+void MouseRay(int MouseX, int MouseY, v3* Origin, v3* Direction);
+int PickPlane(int MouseX, int MouseY, float Z, v3* Hit);
+int PickMeshAt(int MouseX, int MouseY, v3 Position, mesh* Mesh);
 int RectanglesIntersect(rectangle* A, rectangle* B);
 
 int IsRepeat(LPARAM LParam);
@@ -216,24 +230,85 @@ void DebugMatrix(char* Message, matrix* M);
 LRESULT CALLBACK WindowProc(HWND Window, UINT Message, WPARAM WParam, LPARAM LParam);
 // Functions
 
-int PickMeshRectangle(int MouseX, int MouseY, v3 Position, mesh* Mesh) {
+// Rebuilds the camera's matrices and frustum if Position, Near, Far or the
+// client size changed since they were built, and returns whether it did. Cheap
+// enough to call before every use, which keeps the matrices right however
+// the position was changed.
+
+int CameraUpdate() {
+    
+    int Moved = Camera.Position.X != Camera.BuiltPosition.X ||
+        Camera.Position.Y != Camera.BuiltPosition.Y ||
+        Camera.Position.Z != Camera.BuiltPosition.Z;
+    int Resized = ClientWidth != Camera.BuiltWidth || ClientHeight != Camera.BuiltHeight ||
+        Camera.Near != Camera.BuiltNear || Camera.Far != Camera.BuiltFar;
     
-    int Result = 0;
-	float X = ((2.0f * (float)MouseX) / (float)ClientWidth) - 1.0f;
-	float Y = (((2.0f * (float)MouseY) / (float)ClientHeight) - 1.0f) * -1.0f;
+    if(Camera.Version != 0 && !Moved && !Resized) {
+        return 0;
+    }
     
-    X = X / ProjectionMatrix.M[0][0];
-    Y = Y / ProjectionMatrix.M[1][1];
+    if(Camera.Version == 0 || Resized) {
+        
+        float AspectRatio = ClientHeight > 0 ? (float)ClientWidth / (float)ClientHeight : 1.0f;
+        float Near = Camera.Near;
+        float Far = Camera.Far;
+        
+        Camera.Projection = (matrix){{
+            {2.0f * Near / AspectRatio, 0.0f, 0.0f, 0.0f},
+            {0.0f, 2.0f * Near / Camera.Height, 0.0f, 0.0f},
+            {0.0f, 0.0f, Far / (Far - Near), 1.0f},
+            {0.0f, 0.0f, Near * Far / (Near - Far), 0.0f},
+        }};
+        MatrixInverse(&Camera.Projection, &Camera.InverseProjection);
+    }
     
-    matrix InverseViewMatrix = {0};
-    MatrixInverse(&ViewMatrix, &InverseViewMatrix);
+    Camera.View = MatrixTranslation(V3MultiplyScalar(Camera.Position, -1.0f));
+    MatrixInverse(&Camera.View, &Camera.InverseView);
     
-    v3 Direction = {0};
-    Direction.X = X * InverseViewMatrix.M[0][0] + Y * InverseViewMatrix.M[1][0] + InverseViewMatrix.M[2][0];
-    Direction.Y = X * InverseViewMatrix.M[0][1] + Y * InverseViewMatrix.M[1][1] + InverseViewMatrix.M[2][1];
-    Direction.Z = X * InverseViewMatrix.M[0][2] + Y * InverseViewMatrix.M[1][2] + InverseViewMatrix.M[2][2];
+    Camera.ViewProjection = MatrixMultiply(&Camera.View, &Camera.Projection);
+    Camera.InverseViewProjection = MatrixMultiply(&Camera.InverseProjection, &Camera.InverseView);
+    MatrixFrustumPlanes(&Camera.ViewProjection, Camera.Frustum);
+    
+    Camera.BuiltPosition = Camera.Position;
+    Camera.BuiltNear = Camera.Near;
+    Camera.BuiltFar = Camera.Far;
+    Camera.BuiltWidth = ClientWidth;
+    Camera.BuiltHeight = ClientHeight;
+    ++Camera.Version;
+    return 1;
+}
+
+// Whether any of the box may be on screen
+
+int CameraBoxVisible(v3 Min, v3 Max) {
+    CameraUpdate();
+    return PlanesContainBox(Camera.Frustum, PLANE_COUNT, Min, Max);
+}
+
+// Ray from the camera through the mouse, in world space
+
+void MouseRay(int MouseX, int MouseY, v3* Origin, v3* Direction) {
+    CameraUpdate();
+    PickMouseRay(MouseX, MouseY, ClientWidth, ClientHeight, &Camera.Projection, &Camera.InverseView, Origin, Direction);
+}
+
+// Point where the mouse ray meets the plane at height Z, if it is in
+// front of the camera
+
+int PickPlane(int MouseX, int MouseY, float Z, v3* Hit) {
+    v3 Origin, Direction;
+    MouseRay(MouseX, MouseY, &Origin, &Direction);
+    return PickRayPlane(Origin, Direction, Z, Hit);
+}
+
+// Whether the mouse is over Mesh drawn at Position. The mesh needs its
+// pick packs, see CreatePickMesh.
+
+int PickMeshAt(int MouseX, int MouseY, v3 Position, mesh* Mesh) {
+    
+    v3 Origin, Direction;
+    MouseRay(MouseX, MouseY, &Origin, &Direction);
     
-	v3 Origin = Camera.Position;
     matrix TranslatedModel = MatrixTranslation(Position);
     
     matrix InverseModel = {0};
@@ -244,47 +319,8 @@ int PickMeshRectangle(int MouseX, int MouseY, v3 Position, mesh* Mesh) {
     
     V3Normalize(&RayDirection);
     
-    triangle Triangle1 = {
-        .A = {
-            Mesh->Vertices[0], 
-            Mesh->Vertices[1], 
-            Mesh->Vertices[2]
-        },
-        .B = {
-            Mesh->Vertices[5], 
-            Mesh->Vertices[6], 
-            Mesh->Vertices[7]
-        },
-        .C = {
-            Mesh->Vertices[10], 
-            Mesh->Vertices[11], 
-            Mesh->Vertices[12]
-        }
-    };
-    
-    triangle Triangle2 = {
-        .A = {
-            Mesh->Vertices[15], 
-            Mesh->Vertices[16], 
-            Mesh->Vertices[17]
-        },
-        .B = {
-            Mesh->Vertices[20], 
-            Mesh->Vertices[21], 
-            Mesh->Vertices[22]
-        },
-        .C = {
-            Mesh->Vertices[25], 
-            Mesh->Vertices[26], 
-            Mesh->Vertices[27]
-        }
-    };
-    
-    if(RayTriangleIntersect(RayOrigin, RayDirection, &Triangle1) || RayTriangleIntersect(RayOrigin, RayDirection, &Triangle2)) {
-        Result = 1;
-    }
-    
-    return Result;
+    pickHit Hit = {.T = FLT_MAX};
+    return PickMeshRay(&Mesh->Pick, RayOrigin, RayDirection, &Hit);
 }
 
 mesh CreateMesh(float* Vertices, size_t Size, int Stride, int Offset) {
@@ -312,6 +348,14 @@ mesh CreateMesh(float* Vertices, size_t Size, int Stride, int Offset) {
     return Mesh;
 }
 
+// Builds the packs picking tests, for meshes drawn as triangle lists
+
+void CreatePickMesh(mesh* Mesh) {
+    int TriangleCount = Mesh->NumVertices / 3;
+    void* Memory = MemoryAlloc(PickMeshMemorySize(TriangleCount));
+    PickMeshInit(&Mesh->Pick, Memory, Mesh->Vertices, TriangleCount, Mesh->Stride / sizeof(float));
+}
+
 void DrawString(v3 Position, char* String, color Color) {
     
     float UVSize = 1.0f / 16.0f;
@@ -348,17 +392,13 @@ void DrawOne(v3 Position, color Color, mesh Mesh, float UOffset, float VOffset)
     
     ID3D11DeviceContext1_Map(Context, (ID3D11Resource*)ConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource);
     constants* Constants = (constants*)MappedSubresource.pData;
-    Constants->Model = (matrix){
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, 1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 1.0f, 0.0f, 
-        Position.X, 
-        Position.Y, 
-        Position.Z, 1.0f
-    };
+    Constants->Model = (matrix){{
+        {1.0f, 0.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {Position.X, Position.Y, Position.Z, 1.0f},
+    }};
     
-    Constants->View = ViewMatrix;
-    Constants->Projection = ProjectionMatrix;
     Constants->Color = Color;
     Constants->UOffset = UOffset;
     Constants->VOffset = VOffset;
@@ -439,7 +479,7 @@ void GridInit(grid* Grid) {
         Vertices[VerticesIndex + 1 + 1 + Line * 6] = -HalfSize;
         Vertices[VerticesIndex + 1 + 2 + Line * 6] = 0.0f;
         Vertices[VerticesIndex + 1 + 3 + Line * 6] = -HalfSize + (float)Line*Grid->Size;
-        Vertices[VerticesIndex + 1 + 4 + Line * 6] = -HalfSize + (float)Grid->Width;
+        Vertices[VerticesIndex + 1 + 4 + Line * 6] = -HalfSize + (float)Grid->Height;
         Vertices[VerticesIndex + 1 + 5 + Line * 6] = 0.0f;
     }
     
@@ -460,15 +500,13 @@ void GridDraw(grid* Grid) {
     D3D11_MAPPED_SUBRESOURCE MappedSubresource;
     ID3D11DeviceContext1_Map(Context, (ID3D11Resource*)ConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource);
     constants* Constants = (constants*)MappedSubresource.pData;
-    Constants->Model = (matrix){
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, 1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 1.0f, 0.0f, 
-        0.0f, 0.0f, 0.0f, 1.0f, 
-    };
+    Constants->Model = (matrix){{
+        {1.0f, 0.0f, 0.0f, 0.0f},
+        {0.0f, 1.0f, 0.0f, 0.0f},
+        {0.0f, 0.0f, 1.0f, 0.0f},
+        {0.0f, 0.0f, 0.0f, 1.0f},
+    }};
     
-    Constants->View = ViewMatrix;
-    Constants->Projection = ProjectionMatrix;
     Constants->Color = Grid->Color;
     ID3D11DeviceContext1_Unmap(Context, (ID3D11Resource*)ConstantBuffer, 0);
     ID3D11DeviceContext1_Draw(Context, Grid->Mesh.NumVertices, 0);
@@ -502,318 +540,6 @@ DWORD InitTimer(timer* Timer) {
     return 0;
 }
 
-v3 V3Add(v3 A, v3 B) {
-    v3 Result = {0};
-    Result.X += A.X + B.X;
-    Result.Y += A.Y + B.Y;
-    Result.Z += A.Z + B.Z;
-    return Result;
-}
-
-v3 V3Subtract(v3 A, v3 B) {
-    v3 Result = {0};
-    Result.X += A.X - B.X;
-    Result.Y += A.Y - B.Y;
-    Result.Z += A.Z - B.Z;
-    return Result;
-}
-
-v3 V3CrossProduct(v3 A, v3 B) {
-    return (v3) {
-        .X = A.Y * B.Z - A.Z * B.Y,
-        .Y = A.Z * B.X - A.X * B.Z,
-        .Z = A.X * B.Y - A.Y * B.X
-    };
-}
-
-float V3DotProduct(v3 A, v3 B) {
-    return (A.X * B.X + A.Y * B.Y + A.Z * B.Z);
-}
-
-v3 V3AddScalar(v3 A, float B) {
-    v3 Result = {0};
-    Result.X += A.X + B;
-    Result.Y += A.Y + B;
-    Result.Z += A.Z + B;
-    return Result;
-}
-
-v3 V3MultiplyScalar(v3 A, float B) {
-    v3 Result = {0};
-    Result.X = A.X * B;
-    Result.Y = A.Y * B;
-    Result.Z = A.Z * B;
-    return Result;
-}
-
-int V3IsZero(v3 Vector) {
-    if(Vector.X == 0.0f &&
-       Vector.Y == 0.0f &&
-       Vector.Z == 0.0f) {
-        return 1; 
-    }
-    return 0;
-}
-
-int V3Compare(v3 A, v3 B) {
-    if(A.X == B.X &&
-       A.Y == B.Y &&
-       A.Z == B.Z) {
-        return 1; 
-    }
-    return 0;
-}
-
-float V3Length(v3* V) {
-    return sqrt(V->X * V->X + V->Y * V->Y + V->Z * V->Z);
-}
-
-void V3Normalize(v3* V) {
-    float Length = V3Length(V);
-    
-    if (!Length) {
-        V->X = 0.0f;
-        V->Y = 0.0f;
-        V->Z = 0.0f;
-    } else {
-        V->X = V->X / Length;
-        V->Y = V->Y / Length;
-        V->Z = V->Z / Length;
-    }
-}
-
-v3 V3TransformCoord(v3* V, matrix* M) {
-    
-    float Norm = M->M[0][3] * V->X + M->M[1][3] * V->Y + M->M[2][3] * V->Z + M->M[3][3];
-    
-    return (v3) {
-        (M->M[0][0] * V->X + M->M[1][0] * V->Y + M->M[2][0] * V->Z + M->M[3][0]) / Norm,
-        (M->M[0][1] * V->X + M->M[1][1] * V->Y + M->M[2][1] * V->Z + M->M[3][1]) / Norm,
-        (M->M[0][2] * V->X + M->M[1][2] * V->Y + M->M[2][2] * V->Z + M->M[3][2]) / Norm,
-    };
-}
-
-v3 V3TransformNormal(v3* V, matrix* M) {
-    
-    return (v3) {
-        M->M[0][0] * V->X + M->M[1][0] * V->Y + M->M[2][0] * V->Z,
-        M->M[0][1] * V->X + M->M[1][1] * V->Y + M->M[2][1] * V->Z,
-        M->M[0][2] * V->X + M->M[1][2] * V->Y + M->M[2][2] * V->Z
-    };
-}
-
-matrix MatrixTranslation(v3 V) {
-    return (matrix){
-        1.0f, 0.0f, 0.0f, 0.0f, 
-        0.0f, 1.0f, 0.0f, 0.0f, 
-        0.0f, 0.0f, 1.0f, 0.0f, 
-        V.X, V.Y, V.Z, 1.0f
-    };
-}
-
-matrix MatrixMultiply(matrix* A, matrix* B) {
-    return (matrix) {
-        A->M[0][0] * B->M[0][0] + A->M[0][1] * B->M[1][0] + A->M[0][2] * B->M[2][0] + A->M[0][3] * B->M[3][0],
-        A->M[0][0] * B->M[0][1] + A->M[0][1] * B->M[1][1] + A->M[0][2] * B->M[2][1] + A->M[0][3] * B->M[3][1],
-        A->M[0][0] * B->M[0][2] + A->M[0][1] * B->M[1][2] + A->M[0][2] * B->M[2][2] + A->M[0][3] * B->M[3][2],
-        A->M[0][0] * B->M[0][3] + A->M[0][1] * B->M[1][3] + A->M[0][2] * B->M[2][3] + A->M[0][3] * B->M[3][3],
-        A->M[1][0] * B->M[0][0] + A->M[1][1] * B->M[1][0] + A->M[1][2] * B->M[2][0] + A->M[1][3] * B->M[3][0],
-        A->M[1][0] * B->M[0][1] + A->M[1][1] * B->M[1][1] + A->M[1][2] * B->M[2][1] + A->M[1][3] * B->M[3][1],
-        A->M[1][0] * B->M[0][2] + A->M[1][1] * B->M[1][2] + A->M[1][2] * B->M[2][2] + A->M[1][3] * B->M[3][2],
-        A->M[1][0] * B->M[0][3] + A->M[1][1] * B->M[1][3] + A->M[1][2] * B->M[2][3] + A->M[1][3] * B->M[3][3],
-        A->M[2][0] * B->M[0][0] + A->M[2][1] * B->M[1][0] + A->M[2][2] * B->M[2][0] + A->M[2][3] * B->M[3][0],
-        A->M[2][0] * B->M[0][1] + A->M[2][1] * B->M[1][1] + A->M[2][2] * B->M[2][1] + A->M[2][3] * B->M[3][1],
-        A->M[2][0] * B->M[0][2] + A->M[2][1] * B->M[1][2] + A->M[2][2] * B->M[2][2] + A->M[2][3] * B->M[3][2],
-        A->M[2][0] * B->M[0][3] + A->M[2][1] * B->M[1][3] + A->M[2][2] * B->M[2][3] + A->M[2][3] * B->M[3][3],
-        A->M[3][0] * B->M[0][0] + A->M[3][1] * B->M[1][0] + A->M[3][2] * B->M[2][0] + A->M[3][3] * B->M[3][0],
-        A->M[3][0] * B->M[0][1] + A->M[3][1] * B->M[1][1] + A->M[3][2] * B->M[2][1] + A->M[3][3] * B->M[3][1],
-        A->M[3][0] * B->M[0][2] + A->M[3][1] * B->M[1][2] + A->M[3][2] * B->M[2][2] + A->M[3][3] * B->M[3][2],
-        A->M[3][0] * B->M[0][3] + A->M[3][1] * B->M[1][3] + A->M[3][2] * B->M[2][3] + A->M[3][3] * B->M[3][3],
-    };
-}
-
-void MatrixInverse(matrix* Source, matrix* Target) {
-    
-    float Determinant;
-    
-    Target->M[0][0] =
-        + Source->M[1][1] * Source->M[2][2] * Source->M[3][3]
-        - Source->M[1][1] * Source->M[2][3] * Source->M[3][2]
-        - Source->M[2][1] * Source->M[1][2] * Source->M[3][3]
-        + Source->M[2][1] * Source->M[1][3] * Source->M[3][2]
-        + Source->M[3][1] * Source->M[1][2] * Source->M[2][3]
-        - Source->M[3][1] * Source->M[1][3] * Source->M[2][2];
-    
-    Target->M[0][1] =
-        - Source->M[0][1] * Source->M[2][2] * Source->M[3][3]
-        + Source->M[0][1] * Source->M[2][3] * Source->M[3][2]
-        + Source->M[2][1] * Source->M[0][2] * Source->M[3][3]
-        - Source->M[2][1] * Source->M[0][3] * Source->M[3][2]
-        - Source->M[3][1] * Source->M[0][2] * Source->M[2][3]
-        + Source->M[3][1] * Source->M[0][3] * Source->M[2][2];
-    
-    Target->M[0][2] =
-        + Source->M[0][1] * Source->M[1][2] * Source->M[3][3]
-        - Source->M[0][1] * Source->M[1][3] * Source->M[3][2]
-        - Source->M[1][1] * Source->M[0][2] * Source->M[3][3]
-        + Source->M[1][1] * Source->M[0][3] * Source->M[3][2]
-        + Source->M[3][1] * Source->M[0][2] * Source->M[1][3]
-        - Source->M[3][1] * Source->M[0][3] * Source->M[1][2];
-    
-    Target->M[0][3] =
-        - Source->M[0][1] * Source->M[1][2] * Source->M[2][3]
-        + Source->M[0][1] * Source->M[1][3] * Source->M[2][2]
-        + Source->M[1][1] * Source->M[0][2] * Source->M[2][3]
-        - Source->M[1][1] * Source->M[0][3] * Source->M[2][2]
-        - Source->M[2][1] * Source->M[0][2] * Source->M[1][3]
-        + Source->M[2][1] * Source->M[0][3] * Source->M[1][2];
-    
-    Target->M[1][0] =
-        - Source->M[1][0] * Source->M[2][2] * Source->M[3][3]
-        + Source->M[1][0] * Source->M[2][3] * Source->M[3][2]
-        + Source->M[2][0] * Source->M[1][2] * Source->M[3][3]
-        - Source->M[2][0] * Source->M[1][3] * Source->M[3][2]
-        - Source->M[3][0] * Source->M[1][2] * Source->M[2][3]
-        + Source->M[3][0] * Source->M[1][3] * Source->M[2][2];
-    
-    Target->M[1][1] =
-        + Source->M[0][0] * Source->M[2][2] * Source->M[3][3]
-        - Source->M[0][0] * Source->M[2][3] * Source->M[3][2]
-        - Source->M[2][0] * Source->M[0][2] * Source->M[3][3]
-        + Source->M[2][0] * Source->M[0][3] * Source->M[3][2]
-        + Source->M[3][0] * Source->M[0][2] * Source->M[2][3]
-        - Source->M[3][0] * Source->M[0][3] * Source->M[2][2];
-    
-    Target->M[1][2] =
-        - Source->M[0][0] * Source->M[1][2] * Source->M[3][3]
-        + Source->M[0][0] * Source->M[1][3] * Source->M[3][2]
-        + Source->M[1][0] * Source->M[0][2] * Source->M[3][3]
-        - Source->M[1][0] * Source->M[0][3] * Source->M[3][2]
-        - Source->M[3][0] * Source->M[0][2] * Source->M[1][3]
-        + Source->M[3][0] * Source->M[0][3] * Source->M[1][2];
-    
-    Target->M[1][3] =
-        + Source->M[0][0] * Source->M[1][2] * Source->M[2][3]
-        - Source->M[0][0] * Source->M[1][3] * Source->M[2][2]
-        - Source->M[1][0] * Source->M[0][2] * Source->M[2][3]
-        + Source->M[1][0] * Source->M[0][3] * Source->M[2][2]
-        + Source->M[2][0] * Source->M[0][2] * Source->M[1][3]
-        - Source->M[2][0] * Source->M[0][3] * Source->M[1][2];
-    
-    Target->M[2][0] =
-        + Source->M[1][0] * Source->M[2][1] * Source->M[3][3]
-        - Source->M[1][0] * Source->M[2][3] * Source->M[3][1]
-        - Source->M[2][0] * Source->M[1][1] * Source->M[3][3]
-        + Source->M[2][0] * Source->M[1][3] * Source->M[3][1]
-        + Source->M[3][0] * Source->M[1][1] * Source->M[2][3]
-        - Source->M[3][0] * Source->M[1][3] * Source->M[2][1];
-    
-    Target->M[2][1] =
-        - Source->M[0][0] * Source->M[2][1] * Source->M[3][3]
-        + Source->M[0][0] * Source->M[2][3] * Source->M[3][1]
-        + Source->M[2][0] * Source->M[0][1] * Source->M[3][3]
-        - Source->M[2][0] * Source->M[0][3] * Source->M[3][1]
-        - Source->M[3][0] * Source->M[0][1] * Source->M[2][3]
-        + Source->M[3][0] * Source->M[0][3] * Source->M[2][1];
-    
-    Target->M[2][2] =
-        + Source->M[0][0] * Source->M[1][1] * Source->M[3][3]
-        - Source->M[0][0] * Source->M[1][3] * Source->M[3][1]
-        - Source->M[1][0] * Source->M[0][1] * Source->M[3][3]
-        + Source->M[1][0] * Source->M[0][3] * Source->M[3][1]
-        + Source->M[3][0] * Source->M[0][1] * Source->M[1][3]
-        - Source->M[3][0] * Source->M[0][3] * Source->M[1][1];
-    
-    Target->M[2][3] =
-        - Source->M[0][0] * Source->M[1][1] * Source->M[2][3]
-        + Source->M[0][0] * Source->M[1][3] * Source->M[2][1]
-        + Source->M[1][0] * Source->M[0][1] * Source->M[2][3]
-        - Source->M[1][0] * Source->M[0][3] * Source->M[2][1]
-        - Source->M[2][0] * Source->M[0][1] * Source->M[1][3]
-        + Source->M[2][0] * Source->M[0][3] * Source->M[1][1];
-    
-    Target->M[3][0] =
-        - Source->M[1][0] * Source->M[2][1] * Source->M[3][2]
-        + Source->M[1][0] * Source->M[2][2] * Source->M[3][1]
-        + Source->M[2][0] * Source->M[1][1] * Source->M[3][2]
-        - Source->M[2][0] * Source->M[1][2] * Source->M[3][1]
-        - Source->M[3][0] * Source->M[1][1] * Source->M[2][2]
-        + Source->M[3][0] * Source->M[1][2] * Source->M[2][1];
-    
-    Target->M[3][1] =
-        + Source->M[0][0] * Source->M[2][1] * Source->M[3][2]
-        - Source->M[0][0] * Source->M[2][2] * Source->M[3][1]
-        - Source->M[2][0] * Source->M[0][1] * Source->M[3][2]
-        + Source->M[2][0] * Source->M[0][2] * Source->M[3][1]
-        + Source->M[3][0] * Source->M[0][1] * Source->M[2][2]
-        - Source->M[3][0] * Source->M[0][2] * Source->M[2][1];
-    
-    Target->M[3][2] =
-        - Source->M[0][0] * Source->M[1][1] * Source->M[3][2]
-        + Source->M[0][0] * Source->M[1][2] * Source->M[3][1]
-        + Source->M[1][0] * Source->M[0][1] * Source->M[3][2]
-        - Source->M[1][0] * Source->M[0][2] * Source->M[3][1]
-        - Source->M[3][0] * Source->M[0][1] * Source->M[1][2]
-        + Source->M[3][0] * Source->M[0][2] * Source->M[1][1];
-    
-    Target->M[3][3] =
-        + Source->M[0][0] * Source->M[1][1] * Source->M[2][2]
-        - Source->M[0][0] * Source->M[1][2] * Source->M[2][1]
-        - Source->M[1][0] * Source->M[0][1] * Source->M[2][2]
-        + Source->M[1][0] * Source->M[0][2] * Source->M[2][1]
-        + Source->M[2][0] * Source->M[0][1] * Source->M[1][2]
-        - Source->M[2][0] * Source->M[0][2] * Source->M[1][1];
-    
-    Determinant = + Source->M[0][0] * Target->M[0][0] + Source->M[0][1] * Target->M[1][0] + Source->M[0][2] * Target->M[2][0] + Source->M[0][3] * Target->M[3][0];
-    
-    Determinant = 1.0f / Determinant;
-    
-    Target->M[0][0] *= Determinant;
-    Target->M[0][1] *= Determinant;
-    Target->M[0][2] *= Determinant;
-    Target->M[0][3] *= Determinant;
-    Target->M[1][0] *= Determinant;
-    Target->M[1][1] *= Determinant;
-    Target->M[1][2] *= Determinant;
-    Target->M[1][3] *= Determinant;
-    Target->M[2][0] *= Determinant;
-    Target->M[2][1] *= Determinant;
-    Target->M[2][2] *= Determinant;
-    Target->M[2][3] *= Determinant;
-    Target->M[3][0] *= Determinant;
-    Target->M[3][1] *= Determinant;
-    Target->M[3][2] *= Determinant;
-    Target->M[3][3] *= Determinant;
-}
-
-/*
-Möller–Trumbore intersection algorithm
-https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
-*/
-int RayTriangleIntersect(v3 RayOrigin, v3 RayDirection, triangle* Triangle) {
-    const float EPSILON = 0.0000001f;
-    v3 Vertex0 = Triangle->A;
-    v3 Vertex1 = Triangle->B;
-    v3 Vertex2 = Triangle->C;
-    v3 Edge1, Edge2, H, S, Q;
-    float A, F, U, V;
-    Edge1 = V3Subtract(Vertex1, Vertex0);
-    Edge2 = V3Subtract(Vertex2, Vertex0);
-    H = V3CrossProduct(RayDirection, Edge2);
-    A = V3DotProduct(Edge1, H);
-    if(A > -EPSILON && A < EPSILON) return 0;    
-    F = 1.0f / A;
-    S = V3Subtract(RayOrigin, Vertex0);
-    U = F * V3DotProduct(S, H);
-    if(U < 0.0f || U > 1.0f) return 0;
-    Q = V3CrossProduct(S, Edge1);
-    V = F * V3DotProduct(RayDirection, Q);
-    if(V < 0.0f || ((U + V) > 1.0f)) return 0;
-    float T = F * V3DotProduct(Edge2, Q);
-    if(T > EPSILON) return 1;
-    return 0;
-}
-
 int RectanglesIntersect(rectangle* A, rectangle* B) {
     if((A->Left >= B->Left && 
         A->Left <= B->Right ||
@@ -901,10 +627,30 @@ MemoryInit(size_t Size) {
 }
 
 void* MemoryAlloc(size_t Size) {
+    return MemoryArenaAlloc(&Memory, Size);
+}
+
+// Separate arena, for data sized at runtime
+
+memory MemoryCreate(size_t Size) {
+    memory Arena = {
+        .Data = malloc(Size),
+        .Length = Size,
+    };
+    if(Arena.Data == NULL) {
+        Arena.Length = 0;
+    }
+    return Arena;
+}
+
+// Allocations start on 16 bytes, as matrices need
+
+void* MemoryArenaAlloc(memory* Arena, size_t Size) {
     void* Pointer = NULL;
-    if(Memory.Offset+Size <= Memory.Length) {
-        Pointer = &Memory.Data[Memory.Offset];
-        Memory.Offset += Size;
+    Arena->Offset = (Arena->Offset + 15) & ~(size_t)15;
+    if(Arena->Offset+Size <= Arena->Length) {
+        Pointer = &Arena->Data[Arena->Offset];
+        Arena->Offset += Size;
         memset(Pointer, 0, Size);
     }
     return Pointer;
@@ -916,13 +662,6 @@ void CameraUpdateByAcceleration(v3 Acceleration) {
     CameraVelocity = V3Add(CameraVelocity, 
                            V3MultiplyScalar(Acceleration, DeltaTime * Camera.Speed));
     Camera.Position = V3Add(Camera.Position, V3MultiplyScalar(CameraVelocity, DeltaTime * Camera.Speed));
-    
-    ViewMatrix = (matrix){
-        1.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, 1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f,
-        -Camera.Position.X, -Camera.Position.Y, -Camera.Position.Z, 1.0f,
-    };
 }
 
 LRESULT CALLBACK 
@@ -964,6 +703,22 @@ WindowProc(HWND Window, UINT Message, WPARAM WParam, LPARAM LParam) {
         case WM_MBUTTONUP: {
             Mouse.MiddleButtonDown = (Message == WM_MBUTTONDOWN ? 1 : 0);
         } break;
+        case WM_MOUSEMOVE: {
+            
+            // Windows sends one WM_MOUSELEAVE per request, so ask again
+            // each time the mouse comes back in
+            
+            if(!Mouse.Inside) {
+                TRACKMOUSEEVENT Track = {sizeof(Track), TME_LEAVE, Window};
+                TrackMouseEvent(&Track);
+                Mouse.Inside = 1;
+            }
+            Mouse.X = GET_X_LPARAM(LParam);
+            Mouse.Y = GET_Y_LPARAM(LParam);
+        } break;
+        case WM_MOUSELEAVE: {
+            Mouse.Inside = 0;
+        } break;
         case WM_LBUTTONDOWN:
         case WM_RBUTTONDOWN: {
             if(!IsRepeat(LParam)) {
@@ -1217,6 +972,10 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
     Result = ID3D11Device1_CreateBuffer(Device, &ConstantBufferDesc, NULL, &ConstantBuffer);
     assert(SUCCEEDED(Result));
     
+    ConstantBufferDesc.ByteWidth = sizeof(frameConstants);
+    Result = ID3D11Device1_CreateBuffer(Device, &ConstantBufferDesc, NULL, &FrameConstantBuffer);
+    assert(SUCCEEDED(Result));
+    
     // Viewport
     
     Viewport = (D3D11_VIEWPORT){
@@ -1226,28 +985,9 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
     };
     
     
-    // Projection matrix
-    
-    float AspectRatio = (float)ClientWidth / (float)ClientHeight;
-    float Height = 1.0f;
-    float Near = 1.0f;
-    float Far = 100.0f;
+    // Projection and view matrices
     
-    ProjectionMatrix = (matrix){
-        2.0f * Near / AspectRatio, 0.0f, 0.0f, 0.0f, 
-        0.0f, 2.0f * Near / Height, 0.0f, 0.0f, 
-        0.0f, 0.0f, Far / (Far - Near), 1.0f, 
-        0.0f, 0.0f, Near * Far / (Near - Far), 0.0f 
-    };
-    
-    // View matrix
-    
-    ViewMatrix = (matrix){
-        1.0f, 0.0f, 0.0f, 0.0f,
-        0.0f, 1.0f, 0.0f, 0.0f,
-        0.0f, 0.0f, 1.0f, 0.0f,
-        -Camera.Position.X, -Camera.Position.Y, -Camera.Position.Z, 1.0f,
-    };
+    CameraUpdate();
     
     
     // Default meshes
@@ -1263,6 +1003,7 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
     
     MeshTriangle = CreateMesh(TriangleVertexData, sizeof(TriangleVertexData),
                               5, 0);
+    CreatePickMesh(&MeshTriangle);
     
     // Rectangle
     
@@ -1280,6 +1021,7 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
     
     MeshRectangle = CreateMesh(RectangleVertexData, sizeof(RectangleVertexData),
                                5, 0);
+    CreatePickMesh(&MeshRectangle);
     
     // Image
     
@@ -1371,6 +1113,8 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
     
     Init();
     
+    int FrameVersion = 0;
+    
     while(Running) {
         MSG Message;
         while(PeekMessage(&Message, NULL, 0, 0, PM_REMOVE)) {
@@ -1382,6 +1126,17 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
         Input();
         Update();
         
+        // The view and projection go up only when the camera has moved
+        
+        CameraUpdate();
+        if(FrameVersion != Camera.Version) {
+            D3D11_MAPPED_SUBRESOURCE MappedSubresource;
+            ID3D11DeviceContext1_Map(Context, (ID3D11Resource*)FrameConstantBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedSubresource);
+            ((frameConstants*)MappedSubresource.pData)->ViewProjection = Camera.ViewProjection;
+            ID3D11DeviceContext1_Unmap(Context, (ID3D11Resource*)FrameConstantBuffer, 0);
+            FrameVersion = Camera.Version;
+        }
+        
         float ClearColor[] = {
             ColorBackground.R,
             ColorBackground.G,
@@ -1394,6 +1149,7 @@ WinMain(HINSTANCE Instance, HINSTANCE PrevInstance, PSTR CmdLine, int CmdShow) {
         ID3D11DeviceContext1_OMSetRenderTargets(Context, 1, &RenderTargetView, 0);
         
         ID3D11DeviceContext1_VSSetConstantBuffers(Context, 0, 1, &ConstantBuffer);
+        ID3D11DeviceContext1_VSSetConstantBuffers(Context, 1, 1, &FrameConstantBuffer);
         
         ID3D11DeviceContext1_PSSetShaderResources(Context, 0, 1, &ImageShaderResourceView);
         ID3D11DeviceContext1_PSSetSamplers(Context, 0, 1, &ImageSamplerState);
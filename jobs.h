@@ -0,0 +1,224 @@
+// Pool of worker threads that run numbered jobs
+//
+// JobsRun hands out jobs 0 to Count - 1 to whichever thread asks next,
+// the calling thread included, and returns when all of them are done, so
+// a thread that drew short jobs keeps taking more. A pool of one thread
+// starts no threads and runs everything on the caller.
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define JOBS_MAX_THREADS 64
+
+// Types
+
+// Thread is the index of the thread running the job, from 0 to the pool's
+// ThreadCount - 1, so jobs can keep scratch space per thread
+
+typedef void jobFunction(void* Data, int Job, int Thread);
+
+typedef struct jobs jobs;
+
+typedef struct {
+    jobs* Pool;
+    int Index;
+} jobsWorker;
+
+struct jobs {
+#ifdef _WIN32
+    CRITICAL_SECTION Lock;
+    CONDITION_VARIABLE Wake;
+    CONDITION_VARIABLE Done;
+    HANDLE Threads[JOBS_MAX_THREADS];
+#else
+    pthread_mutex_t Lock;
+    pthread_cond_t Wake;
+    pthread_cond_t Done;
+    pthread_t Threads[JOBS_MAX_THREADS];
+#endif
+    jobsWorker Workers[JOBS_MAX_THREADS];
+    jobFunction* Function;
+    void* Data;
+    int Next;
+    int Count;
+    int Busy;
+    int Quit;
+    int ThreadCount;
+};
+
+// Declarations
+
+void JobsStart(jobs* Jobs, int ThreadCount);
+void JobsStop(jobs* Jobs);
+void JobsRun(jobs* Jobs, jobFunction* Function, void* Data, int Count);
+int JobsProcessorCount();
+
+void JobsWork(jobs* Jobs, int Thread);
+void JobsLock(jobs* Jobs);
+void JobsUnlock(jobs* Jobs);
+void JobsWait(jobs* Jobs, int Done);
+void JobsSignal(jobs* Jobs, int Done);
+
+// Functions
+
+int JobsProcessorCount() {
+#ifdef _WIN32
+    SYSTEM_INFO Info;
+    GetSystemInfo(&Info);
+    int Count = (int)Info.dwNumberOfProcessors;
+#else
+    int Count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return Count < 1 ? 1 : Count > JOBS_MAX_THREADS ? JOBS_MAX_THREADS : Count;
+}
+
+void JobsLock(jobs* Jobs) {
+#ifdef _WIN32
+    EnterCriticalSection(&Jobs->Lock);
+#else
+    pthread_mutex_lock(&Jobs->Lock);
+#endif
+}
+
+void JobsUnlock(jobs* Jobs) {
+#ifdef _WIN32
+    LeaveCriticalSection(&Jobs->Lock);
+#else
+    pthread_mutex_unlock(&Jobs->Lock);
+#endif
+}
+
+// Waits on Done, or on Wake for new jobs, with the lock held
+
+void JobsWait(jobs* Jobs, int Done) {
+#ifdef _WIN32
+    SleepConditionVariableCS(Done ? &Jobs->Done : &Jobs->Wake, &Jobs->Lock, INFINITE);
+#else
+    pthread_cond_wait(Done ? &Jobs->Done : &Jobs->Wake, &Jobs->Lock);
+#endif
+}
+
+void JobsSignal(jobs* Jobs, int Done) {
+#ifdef _WIN32
+    WakeAllConditionVariable(Done ? &Jobs->Done : &Jobs->Wake);
+#else
+    pthread_cond_broadcast(Done ? &Jobs->Done : &Jobs->Wake);
+#endif
+}
+
+// Runs jobs until there are none left, with the lock held. Jobs are large,
+// a whole tile of a flood or a band of rows, so taking the lock for each
+// one costs nothing next to running it.
+
+void JobsWork(jobs* Jobs, int Thread) {
+    while(Jobs->Next < Jobs->Count) {
+        
+        int Job = Jobs->Next++;
+        ++Jobs->Busy;
+        JobsUnlock(Jobs);
+        
+        Jobs->Function(Jobs->Data, Job, Thread);
+        
+        JobsLock(Jobs);
+        if(--Jobs->Busy == 0 && Jobs->Next == Jobs->Count) {
+            JobsSignal(Jobs, 1);
+        }
+    }
+}
+
+#ifdef _WIN32
+DWORD WINAPI JobsThread(void* Parameter) {
+#else
+void* JobsThread(void* Parameter) {
+#endif
+    
+    jobsWorker* Worker = (jobsWorker*)Parameter;
+    jobs* Jobs = Worker->Pool;
+    
+    JobsLock(Jobs);
+    while(!Jobs->Quit) {
+        JobsWork(Jobs, Worker->Index);
+        if(!Jobs->Quit) {
+            JobsWait(Jobs, 0);
+        }
+    }
+    JobsUnlock(Jobs);
+    
+    return 0;
+}
+
+// ThreadCount counts the calling thread, which works in JobsRun too
+
+void JobsStart(jobs* Jobs, int ThreadCount) {
+    
+    memset(Jobs, 0, sizeof(*Jobs));
+    Jobs->ThreadCount = ThreadCount < 1 ? 1 : ThreadCount > JOBS_MAX_THREADS ? JOBS_MAX_THREADS : ThreadCount;
+
+#ifdef _WIN32
+    InitializeCriticalSection(&Jobs->Lock);
+    InitializeConditionVariable(&Jobs->Wake);
+    InitializeConditionVariable(&Jobs->Done);
+#else
+    pthread_mutex_init(&Jobs->Lock, NULL);
+    pthread_cond_init(&Jobs->Wake, NULL);
+    pthread_cond_init(&Jobs->Done, NULL);
+#endif
+    
+    for(int Index = 1; Index < Jobs->ThreadCount; ++Index) {
+        Jobs->Workers[Index] = (jobsWorker){Jobs, Index};
+#ifdef _WIN32
+        Jobs->Threads[Index] = CreateThread(NULL, 0, JobsThread, &Jobs->Workers[Index], 0, NULL);
+#else
+        pthread_create(&Jobs->Threads[Index], NULL, JobsThread, &Jobs->Workers[Index]);
+#endif
+    }
+}
+
+void JobsStop(jobs* Jobs) {
+    
+    JobsLock(Jobs);
+    Jobs->Quit = 1;
+    JobsSignal(Jobs, 0);
+    JobsUnlock(Jobs);
+    
+    for(int Index = 1; Index < Jobs->ThreadCount; ++Index) {
+#ifdef _WIN32
+        WaitForSingleObject(Jobs->Threads[Index], INFINITE);
+        CloseHandle(Jobs->Threads[Index]);
+#else
+        pthread_join(Jobs->Threads[Index], NULL);
+#endif
+    }
+
+#ifdef _WIN32
+    DeleteCriticalSection(&Jobs->Lock);
+#else
+    pthread_mutex_destroy(&Jobs->Lock);
+    pthread_cond_destroy(&Jobs->Wake);
+    pthread_cond_destroy(&Jobs->Done);
+#endif
+}
+
+// Blocks until Function has run for every job from 0 to Count - 1
+
+void JobsRun(jobs* Jobs, jobFunction* Function, void* Data, int Count) {
+    
+    JobsLock(Jobs);
+    
+    Jobs->Function = Function;
+    Jobs->Data = Data;
+    Jobs->Next = 0;
+    Jobs->Count = Count;
+    JobsSignal(Jobs, 0);
+    
+    JobsWork(Jobs, 0);
+    while(Jobs->Busy > 0) {
+        JobsWait(Jobs, 1);
+    }
+    
+    JobsUnlock(Jobs);
+}
@@ -1,59 +1,60 @@
 #include "engine.h"
+#include "board.h"
+#include "world.h"
+
+// Default board, override with: a.exe width height bombs [seed]
+// or play the infinite board with: a.exe infinite [bomb percent] [seed]
 
-#define MAX_ARRAY_LENGTH 4096
 #define MAX_BOMBS 9
 #define X_TILES 10
 #define Y_TILES 10
+#define INFINITE_BOMB_PERCENT 15.0
+
+// Distance from a tile's edge, in tiles, within which picking checks the
+// tile meshes instead of rounding
+
+#define PICK_EDGE 0.01f
+
+// Farthest the camera goes from the board. Every visible tile is a draw
+// call, so this bounds the draws per frame, about the square of it on a
+// square window. The far plane sits behind it.
 
-enum {EMPTY, NUMBER, BOMB};
-
-// Types
-
-typedef struct { 
-    v3 Position;
-    mesh Mesh;
-    color Color;
-    int Type;
-    int Hit;
-    int Visible;
-    int Flagged;
-    int BombsNearAmount;
-} entity;
-
-typedef struct {
-    entity* Items;
-    int Length;
-    int Capacity;
-    int Index;
-} entityArray;
-
-typedef struct {
-    v3 Items[X_TILES * Y_TILES];
-    int First;
-    int Index;
-    int Length;
-} queue;
-
-typedef struct {
-    v3 Items[8];
-    int Length;
-} neighbors;
+#define MAX_VIEW_DISTANCE 100.0f
+#define MIN_VIEW_DISTANCE 2.0f
 
 // Globals
 
-entityArray Entities;
+board Board;
+world World;
+memory BoardMemory;
+jobs Jobs;
 timer Timer;
 grid Grid;
 
-int Flags = MAX_BOMBS;
-int Playing = 1;
-int FirstPick;
-int Win;
+int BoardWidth = X_TILES;
+int BoardHeight = Y_TILES;
+int BoardBombs = MAX_BOMBS;
+unsigned long long BoardSeed;
+unsigned int WorldDensity = (unsigned int)(INFINITE_BOMB_PERCENT / 100.0 * 4294967296.0);
+int Infinite;
+int Started;
+
+// Tile under the mouse, and how far around it to highlight: -1 for none,
+// 0 for the tile, 1 for the 3x3 a click on its number would chord
+
+int HoverX;
+int HoverY;
+int HoverReach = -1;
+
+// Seeds of the following games
+
+rng Seeds;
 
 // colors
 
 color ColorEmpty = {0.1f, 0.1f, 0.1f, 1.0f};
 color ColorHidden = {0.02f, 0.02f, 0.02f, 1.0f};
+color ColorHover = {0.06f, 0.06f, 0.06f, 1.0f};
 color ColorBomb = {0.1f, 0.1f, 0.1f, 1.0f};
 color ColorFlag = {0.2f, 0.2f, 0.2f, 1.0f};
 color ColorBombHit = {0.8f, 0.1f, 0.1f, 1.0f};
@@ -71,145 +72,143 @@ color Color8 = {0.6f, 0.1f, 0.1f, 1.0f};
 
 // Declarations
 
-void AddEntityToArray(entity* Entity, entityArray* Array);
-void DrawEntity(entity* Entity);
-void ClearArray(entityArray* Array);
-void QueueAdd(queue* Queue, v3 Position);
-void FloodEmpty(v3 Start);
-void CalculateNumbers();
-void RevealAll();
-void RevealNumbersAroundPosition(v3 Position);
-
-neighbors GetNeighborsByType(v3 Position, int Type);
-v3 QueuePop(queue* Queue);
-
-int QueueHasItem(queue* Queue, v3 Position);
-int AddBomb();
-
-void RevealNumbersAroundPosition(v3 Position) {
-    neighbors Neighbors = GetNeighborsByType(Position, NUMBER);
-    for(int Index = 0; Index < Neighbors.Length; ++Index) {
-        int X = Neighbors.Items[Index].X;
-        int Y = Neighbors.Items[Index].Y;
-        Entities.Items[Y * X_TILES + X].Visible = 1;
-    }
+void DrawTile(int X, int Y);
+void UpdateHover();
+void GetVisibleTiles(int* MinX, int* MinY, int* MaxX, int* MaxY);
+void ClampCamera();
+
+int IsPlaying();
+
+int PickTile(int MouseX, int MouseY, int* X, int* Y);
+
+int IsPlaying() {
+    return Infinite ? World.Playing : Board.Playing;
+}
+
+// Keeps the board between the near plane and MAX_VIEW_DISTANCE. Boards
+// too large to fit are seen a part at a time.
+
+void ClampCamera() {
+    
+    Camera.Far = 2.0f * MAX_VIEW_DISTANCE;
+    
+    if(Camera.Position.Z < -MAX_VIEW_DISTANCE) Camera.Position.Z = -MAX_VIEW_DISTANCE;
+    if(Camera.Position.Z > -MIN_VIEW_DISTANCE) Camera.Position.Z = -MIN_VIEW_DISTANCE;
 }
 
-neighbors GetNeighborsByType(v3 Position, int Type) {
+// Range of tiles the camera can see, empty if the board is behind it
+
+void GetVisibleTiles(int* MinX, int* MinY, int* MaxX, int* MaxY) {
     
-    neighbors Neighbors = {0};
-    int NeighborIndex = 0;
+    float Distance = -Camera.Position.Z;
+    float HalfWidth = Distance / Camera.Projection.M[0][0];
+    float HalfHeight = Distance / Camera.Projection.M[1][1];
     
-    int XYOffsets[] = {
-        -1,-1, 0,-1, 1,-1,
-        -1, 0,       1, 0,
-        -1, 1, 0, 1, 1, 1,  
-    };
+    *MinX = (int)floorf(Camera.Position.X - HalfWidth);
+    *MinY = (int)floorf(Camera.Position.Y - HalfHeight);
+    *MaxX = (int)ceilf(Camera.Position.X + HalfWidth);
+    *MaxY = (int)ceilf(Camera.Position.Y + HalfHeight);
     
-    for(int Index = 0; Index < 16; Index += 2) {
-        int XNeighbor = Position.X + XYOffsets[Index];
-        int YNeighbor = Position.Y + XYOffsets[Index+1];
-        if(XNeighbor < 0 || YNeighbor < 0 || XNeighbor >= X_TILES || YNeighbor >= Y_TILES || (Entities.Items[YNeighbor * X_TILES + XNeighbor].Type != Type)) {
-            continue;
-        }
-        Neighbors.Items[NeighborIndex++] = (v3){XNeighbor, YNeighbor, 0.0f};
-        ++Neighbors.Length;
+    if(!Infinite) {
+        if(*MinX < 0) *MinX = 0;
+        if(*MinY < 0) *MinY = 0;
+        if(*MaxX > Board.Width - 1) *MaxX = Board.Width - 1;
+        if(*MaxY > Board.Height - 1) *MaxY = Board.Height - 1;
     }
     
-    return Neighbors;
+    // Nothing when the range's tiles are all outside the view frustum, as
+    // when the board is behind the camera
+    
+    v3 Min = {*MinX - 0.5f, *MinY - 0.5f, 0.0f};
+    v3 Max = {*MaxX + 0.5f, *MaxY + 0.5f, 0.0f};
+    if(Distance <= 0.0f || *MinX > *MaxX || *MinY > *MaxY || !CameraBoxVisible(Min, Max)) {
+        *MaxX = *MinX - 1;
+    }
 }
 
-void QueueAdd(queue* Queue, v3 Position) {
-    ++Queue->Length;
-    Queue->Items[Queue->Index++] = Position;
-}
+// Returns the tile under the mouse. Tiles are unit squares centered on
+// their coordinates in the plane Z = 0, so the point where the mouse ray
+// meets the plane rounds to the tile. Points within PICK_EDGE of an edge
+// could round either way, so the meshes of the tiles around them are
+// asked in the order the scan over all visible tiles used to, which picks
+// the same tile as that scan did.
 
-v3 QueuePop(queue* Queue) {
-    --Queue->Length;
-    return Queue->Items[Queue->First++];
-}
-
-int QueueHasItem(queue* Queue, v3 Position) {
-    for(int Index = 0; Index < Queue->Length; ++Index) {
-        if(V3Compare(Queue->Items[Index], Position)) {
-            return 1;
-        }
+int PickTile(int MouseX, int MouseY, int* X, int* Y) {
+    
+    v3 Hit;
+    if(!PickPlane(MouseX, MouseY, 0.0f, &Hit)) {
+        return 0;
     }
-    return 0;
-}
-
-void FloodEmpty(v3 Start) {
     
-    queue Frontier = {0};
-    queue Reached = {0};
+    int MinX, MinY, MaxX, MaxY;
+    GetVisibleTiles(&MinX, &MinY, &MaxX, &MaxY);
     
-    QueueAdd(&Frontier, Start);
-    QueueAdd(&Reached, Start);
+    int FirstX = (int)ceilf(Hit.X - 0.5f - PICK_EDGE);
+    int FirstY = (int)ceilf(Hit.Y - 0.5f - PICK_EDGE);
+    int LastX = (int)floorf(Hit.X + 0.5f + PICK_EDGE);
+    int LastY = (int)floorf(Hit.Y + 0.5f + PICK_EDGE);
     
-    RevealNumbersAroundPosition(Start);
+    // A range clamped to the visible tiles can shrink to one tile the
+    // mouse is not over, so only an unclamped one skips the meshes
     
-    // Flood from Start and make visible
+    int Clamped = FirstX < MinX || FirstY < MinY || LastX > MaxX || LastY > MaxY;
+    if(FirstX < MinX) FirstX = MinX;
+    if(FirstY < MinY) FirstY = MinY;
+    if(LastX > MaxX) LastX = MaxX;
+    if(LastY > MaxY) LastY = MaxY;
     
-    while(Frontier.Length > 0) {
-        v3 Current = QueuePop(&Frontier);
-        neighbors Neighbors = GetNeighborsByType(Current, EMPTY);
-        
-        for(int Index = 0; Index < Neighbors.Length; ++Index) {
-            if(!QueueHasItem(&Reached, Neighbors.Items[Index])) {
-                QueueAdd(&Reached, Neighbors.Items[Index]);
-                QueueAdd(&Frontier, Neighbors.Items[Index]);
-                
-                int X = Neighbors.Items[Index].X;
-                int Y = Neighbors.Items[Index].Y;
-                Entities.Items[Y * X_TILES + X].Visible = 1;
-                
-                RevealNumbersAroundPosition(Entities.Items[Y * X_TILES + X].Position);
+    if(!Clamped && FirstX == LastX && FirstY == LastY) {
+        *X = FirstX;
+        *Y = FirstY;
+        return 1;
+    }
+    
+    for(int TileY = FirstY; TileY <= LastY; ++TileY) {
+        for(int TileX = FirstX; TileX <= LastX; ++TileX) {
+            if(PickMeshAt(MouseX, MouseY, (v3){TileX, TileY}, &MeshRectangle)) {
+                *X = TileX;
+                *Y = TileY;
+                return 1;
             }
         }
     }
-    
-}
-
-entityArray NewEntityArray(int Capacity) {
-    entityArray Array = {
-        .Items = MemoryAlloc(Capacity * sizeof(entity)),
-        .Capacity = Capacity,
-    };
-    return Array;
+    return 0;
 }
 
-// Overrides elements starting from index 0 if overflowing
+// Picks the tile under the mouse every frame, which costs the same on any
+// board now that picking meets the board plane instead of scanning tiles
 
-void AddEntityToArray(entity* Entity, entityArray* Array) {
-    Array->Items[Array->Index++] = *Entity;
-    if(Array->Length < Array->Capacity) {
-        ++Array->Length;
-    }
-    if(Array->Index >= Array->Capacity) {
-        Array->Index = 0;
+void UpdateHover() {
+    
+    HoverReach = -1;
+    if(!Mouse.Inside || !PickTile(Mouse.X, Mouse.Y, &HoverX, &HoverY)) {
+        return;
     }
-}
-
-void RevealAll() {
-    for(int Index = 0; Index < Entities.Length; ++Index) {
-        Entities.Items[Index].Visible = 1;
+    
+    tile Tile = Infinite ? WorldGetTile(&World, HoverX, HoverY) : BoardGetTile(&Board, HoverX, HoverY);
+    if(!Tile.Visible) {
+        HoverReach = 0;
+    } else if(Tile.Type == NUMBER) {
+        HoverReach = 1;
     }
 }
 
-void DrawEntity(entity* Entity) {
+void DrawTile(int X, int Y) {
+    
+    tile Tile = Infinite ? WorldGetTile(&World, X, Y) : BoardGetTile(&Board, X, Y);
     
     float UVSize = 1.0f / 16.0f;
     float UOffset = 2 * UVSize;
     float VOffset = 11 * UVSize;
     color Color = ColorHidden;
     
-    if(Entity->Visible) {
-        switch(Entity->Type) {
+    if(Tile.Visible) {
+        switch(Tile.Type) {
             case NUMBER: {
-                char Char = '0' + Entity->BombsNearAmount;
+                char Char = '0' + Tile.BombsNearAmount;
                 UOffset = Char % 16 * UVSize;
                 VOffset = Char / 16 * UVSize;
-                switch(Entity->BombsNearAmount) {
+                switch(Tile.BombsNearAmount) {
                     case 1: { Color = Color1; } break; 
                     case 2: { Color = Color2; } break; 
                     case 3: { Color = Color3; } break; 
@@ -233,109 +232,119 @@ void DrawEntity(entity* Entity) {
         }
     }
     
-    if(Entity->Flagged) {
+    // Hidden tiles a click would open
+    
+    if(!Tile.Visible && !Tile.Flagged &&
+       X >= HoverX - HoverReach && X <= HoverX + HoverReach &&
+       Y >= HoverY - HoverReach && Y <= HoverY + HoverReach) {
+        Color = ColorHover;
+    }
+    
+    if(Tile.Flagged) {
         UOffset = 11 * UVSize;
         VOffset = 15 * UVSize;
         Color = ColorFlag;
     }
     
-    if(!Playing && Entity->Hit) {
+    if(!IsPlaying() && Tile.Hit) {
         Color = ColorBombHit;
     }
     
-    DrawOne(Entity->Position, 
+    DrawOne((v3){X, Y}, 
             Color, 
-            Entity->Mesh, 
+            MeshRectangle, 
             UOffset, 
             VOffset);
 }
 
-void CalculateNumbers() {
+void Init() {
     
-    for(int Y = 0; Y < Y_TILES; ++Y) {
-        for(int X = 0; X < X_TILES; ++X) {
-            
-            entity* Entity = &Entities.Items[Y * X_TILES + X];
+    // Board size or infinite mode, and seed, from the command line on first start
+    
+    if(!Started) {
+        
+        Started = 1;
+        JobsStart(&Jobs, JobsProcessorCount());
+        RngSeed(&Seeds, time(NULL));
+        BoardSeed = RngNext(&Seeds);
+        
+        if(__argc >= 2 && strcmp(__argv[1], "infinite") == 0) {
             
-            if(Entity->Type == BOMB) continue;
+            Infinite = 1;
+            Camera.Position = (v3){0.0f, 0.0f, -40.0f};
             
-            Entity->BombsNearAmount = 0;
-            Entity->Type = EMPTY;
+            if(__argc >= 3) {
+                double Percent = atof(__argv[2]);
+                if(Percent > 0.0 && Percent < 100.0) {
+                    WorldDensity = (unsigned int)(Percent / 100.0 * 4294967296.0);
+                }
+            }
+            if(__argc == 4) {
+                BoardSeed = strtoull(__argv[3], NULL, 10);
+            }
             
-            neighbors Neighbors = GetNeighborsByType(Entity->Position, BOMB);
+        } else if(__argc == 4 || __argc == 5) {
             
-            if(Neighbors.Length > 0) {
-                Entity->Type = NUMBER;
-                Entity->BombsNearAmount = Neighbors.Length;
+            int Width = atoi(__argv[1]);
+            int Height = atoi(__argv[2]);
+            int Bombs = atoi(__argv[3]);
+            if(BoardSizeFits(Width, Height) &&
+               Bombs >= 0 && Bombs < Width * Height) {
+                BoardWidth = Width;
+                BoardHeight = Height;
+                BoardBombs = Bombs;
+            }
+            if(__argc == 5) {
+                BoardSeed = strtoull(__argv[4], NULL, 10);
             }
         }
+    } else {
+        BoardSeed = RngNext(&Seeds);
     }
-}
-
-int AddBomb(v3* Position) {
-    int X = rand() % X_TILES;
-    int Y = rand() % Y_TILES;
     
-    // Exclude position if not NULL
-    if(Position != NULL &&
-       (float)X == Position->X &&
-       (float)Y == Position->Y) {
-        return 0;
-    }
+    // Board storage, sized for the board and reused between games
     
-    if(Entities.Items[Y * X_TILES + X].Type == EMPTY) {
-        Entities.Items[Y * X_TILES + X].Type = BOMB;
-        return 1;
+    if(!Infinite && (Board.Width != BoardWidth || Board.Height != BoardHeight)) {
+        
+        size_t Size = BoardMemorySize(BoardWidth, BoardHeight);
+        
+        BoardStopFlood(&Board);
+        free(BoardMemory.Data);
+        BoardMemory = MemoryCreate(Size);
+        assert(BoardMemory.Data);
+        
+        BoardInit(&Board, MemoryArenaAlloc(&BoardMemory, Size), BoardWidth, BoardHeight);
+        Board.Jobs = &Jobs;
+        Board.FloodBudget = BOARD_FLOOD_BUDGET;
+        Board.LazyNumbers = 1;
+        Board.SafeOpening = 1;
+        
+        Grid = (grid){ 
+            .Width = BoardWidth, 
+            .Height = BoardHeight,
+            .Color = ColorGrid,
+        };
+        
+        GridInit(&Grid);
+        
+        // Fit the board in view
+        
+        int Longest = BoardWidth > BoardHeight ? BoardWidth : BoardHeight;
+        Camera.Position = (v3){BoardWidth / 2 - 1, BoardHeight / 2, -1.4f * Longest};
+        ClampCamera();
     }
-    return 0;
-}
-
-void Init() {
-    
-    Entities = NewEntityArray(X_TILES * Y_TILES);
-    
-    Grid = (grid){ 
-        .Width = 10, 
-        .Height = 10,
-        .Color = ColorGrid,
-    };
-    
-    GridInit(&Grid);
     
     // Reset things when starting a new game
     
-    FirstPick = 0;
-    Playing = 1;
-    Win = 0;
-    Flags = MAX_BOMBS;
+    if(Infinite) {
+        WorldNewGame(&World, WorldDensity, BoardSeed);
+    } else {
+        BoardNewGame(&Board, BoardBombs, BoardSeed);
+    }
     InitTimer(&Timer);
     Mouse.LeftButtonPressed = 0;
     Mouse.RightButtonPressed = 0;
     
-    // Empty tiles
-    
-    for(int Y = 0; Y < Y_TILES; ++Y) {
-        for(int X = 0; X < X_TILES; ++X) {
-            entity Entity = {
-                .Position = {X, Y},
-                .Color = ColorHidden,
-                .Mesh = MeshRectangle,
-                .Type = EMPTY,
-                .Visible = 0,
-            };
-            AddEntityToArray(&Entity, &Entities);
-        }
-    }
-    
-    // Bombs
-    
-    int Bombs = 0;
-    while((Bombs += AddBomb(NULL)) < MAX_BOMBS);
-    
-    // Numbers
-    
-    CalculateNumbers();
-    
 }
 
 void Input() {
@@ -347,87 +356,45 @@ void Input() {
         KeyPressed[SPACE] = 0;
     }
     
-    if(!Playing) return;
+    HoverReach = -1;
+    if(!IsPlaying()) return;
     
     // Pick
     
+    int X, Y;
+    
     if(Mouse.LeftButtonPressed) {
         
-        if(FirstPick == 0) FirstPick = 1;
-        
         Mouse.LeftButtonPressed = 0;
         
-        for(int Index = 0; Index < Entities.Length; ++Index) {
-            
-            entity* Entity = &Entities.Items[Index];
-            
-            if(Entity->Flagged) continue;
-            
-            if(PickMeshRectangle(Mouse.X, Mouse.Y, Entity->Position, &Entity->Mesh)) {
-                Entity->Visible = 1;
-                
-                if(Entity->Type == EMPTY) {
-                    FloodEmpty(Entity->Position);
-                } else if(Entity->Type == BOMB) {
-                    // Relocate bomb if hit with first pick
-                    if(FirstPick == 1) {
-                        Entity->Type = EMPTY;
-                        while(AddBomb(&Entity->Position) == 0);
-                        CalculateNumbers();
-                        FloodEmpty(Entity->Position);
-                    } else {
-                        Playing = 0;
-                        Win = 0;
-                        RevealAll();
-                        Entity->Hit = 1;
-                    }
-                }
-            }
-        }
+        // A click on a revealed number chords it
         
-        // Check win condition
-        
-        if(Playing) {
-            
-            int End = 1;
-            
-            // If any non bomb is hidden, the game continues
-            for(int Index = 0; Index < Entities.Length; ++Index) {
-                entity* Entity = &Entities.Items[Index];
-                if(!Entity->Visible && Entity->Type != BOMB) {
-                    End = 0;
-                    break;
+        if(PickTile(Mouse.X, Mouse.Y, &X, &Y)) {
+            if(Infinite) {
+                if(WorldGetTile(&World, X, Y).Visible) {
+                    WorldChord(&World, X, Y);
+                } else {
+                    WorldReveal(&World, X, Y);
+                }
+            } else {
+                if(BoardGetTile(&Board, X, Y).Visible) {
+                    BoardChord(&Board, X, Y);
+                } else {
+                    BoardReveal(&Board, X, Y);
                 }
-            }
-            if(End) {
-                Playing = 0;
-                Win = 1;
-                RevealAll();
             }
         }
-        
-        FirstPick = 2;
     }
     
     if(Mouse.RightButtonPressed) {
         
         Mouse.RightButtonPressed = 0;
         
-        for(int Index = 0; Index < Entities.Length; ++Index) {
-            
-            entity* Entity = &Entities.Items[Index];
-            
-            if(PickMeshRectangle(Mouse.X, Mouse.Y, Entity->Position, &Entity->Mesh)) {
-                
-                if(Entity->Flagged) {
-                    Entity->Flagged = 0;
-                    ++Flags;
-                } else {
-                    if(Flags > 0) {
-                        Entity->Flagged = 1;
-                        --Flags;
-                    }
-                }
+        if(PickTile(Mouse.X, Mouse.Y, &X, &Y)) {
+            if(Infinite) {
+                WorldFlag(&World, X, Y);
+            } else {
+                BoardFlag(&Board, X, Y);
             }
         }
     }
@@ -465,60 +432,105 @@ void Input() {
     }
     
     CameraUpdateByAcceleration(CameraAcceleration);
+    ClampCamera();
+    
+    // Hover, after the clicks and the camera so it shows this frame's board
     
+    UpdateHover();
 }
 
 void Update() {
-    if(!Playing) return;
+    
+    // Large floods take several frames
+    
+    if(Infinite) {
+        WorldFlood(&World, WORLD_FLOOD_BUDGET);
+    } else {
+        BoardFlood(&Board, BOARD_FLOOD_BUDGET);
+    }
+    
+    if(!IsPlaying()) return;
     UpdateTimer(&Timer); 
 };
 
 void Draw() {
     
-    // Entities
+    // Tiles
     
-    for(int Index = 0; Index < Entities.Length; ++Index) {
-        entity* Entity = &Entities.Items[Index];
-        DrawEntity(Entity);
+    int MinX, MinY, MaxX, MaxY;
+    GetVisibleTiles(&MinX, &MinY, &MaxX, &MaxY);
+    
+    for(int Y = MinY; Y <= MaxY; ++Y) {
+        for(int X = MinX; X <= MaxX; ++X) {
+            DrawTile(X, Y);
+        }
     }
     
-    // Texts
+    // Texts go around the board, or along the edges of the view when the
+    // board never ends
+    
+    float Left = 0.0f;
+    float Right = Board.Width;
+    float Top = Board.Height;
+    float Bottom = -1.0f;
+    
+    if(Infinite) {
+        Left = MinX + 1.0f;
+        Right = MaxX - 1.0f;
+        Top = MaxY - 1.0f;
+        Bottom = MinY + 2.0f;
+    }
     
     char* TimerText = MemoryAlloc(32 * sizeof(*TimerText));
     sprintf(TimerText, "%3d", (int)(Timer.ElapsedMilliSeconds / 1000.0f));
     DrawString(
-               (v3){7.0f, 10.0f, 0.0f},
+               (v3){Right - 3.0f, Top, 0.0f},
                TimerText,
                ColorText
                );
     
     
     char* FlagsText = MemoryAlloc(32 * sizeof(*FlagsText));
-    sprintf(FlagsText, "%2d", Flags);
+    sprintf(FlagsText, "%2d", Infinite ? World.Flags : Board.Flags);
     
     DrawString(
-               (v3){0.0f, 10.0f, 0.0f},
+               (v3){Left, Top, 0.0f},
                FlagsText,
                ColorText
                );
     
     
-    if(!Playing) {
-        if(Win) {
+    if(!IsPlaying()) {
+        if(!Infinite && Board.Win) {
             DrawString(
-                       (v3){0.0f, -1.0f, 0.0f},
+                       (v3){Left, Bottom, 0.0f},
                        "You win!",
                        ColorTextWin
                        );
         } else {
             DrawString(
-                       (v3){0.0f, -1.0f, 0.0f},
+                       (v3){Left, Bottom, 0.0f},
                        "Game over!",
                        ColorTextGameOver
                        );
         }
         
+        // Enough to play this board again from the command line
+        
+        char* SeedText = MemoryAlloc(32 * sizeof(*SeedText));
+        sprintf(SeedText, "Seed %llu", Infinite ? World.Seed : Board.Seed);
+        
+        DrawString(
+                   (v3){Left, Bottom - 1.0f, 0.0f},
+                   SeedText,
+                   ColorText
+                   );
+        
     }
     
-    GridDraw(&Grid);
+    // The grid is made for a board's size
+    
+    if(!Infinite) {
+        GridDraw(&Grid);
+    }
 }
@@ -0,0 +1,652 @@
+// Ray picking against meshes, independent of the OS and graphics API
+//
+// A pickMesh keeps a mesh's triangles in packs of PICK_WIDTH, one array per
+// coordinate, so Möller–Trumbore tests a whole pack at once. A pickScene
+// places meshes in the world and keeps a bounding volume hierarchy over
+// them, so a ray only tests the meshes whose boxes it passes through,
+// nearest box first. Needs maths.h.
+#include <string.h>
+#include <float.h>
+
+// Packs are as wide as the widest float vectors the compiler targets
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define PICK_AVX
+#define PICK_WIDTH 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PICK_SSE
+#define PICK_WIDTH 4
+#else
+#define PICK_WIDTH 4
+#endif
+
+// Hits closer than this to the ray's origin don't count, as in
+// RayTriangleIntersect
+
+#define PICK_EPSILON 0.0000001f
+
+// Leaves of the hierarchy hold at most this many instances
+
+#define PICK_LEAF_SIZE 4
+
+// Deeper than the hierarchy over any instance count that fits an int,
+// which splits at the median
+
+#define PICK_STACK_SIZE 64
+
+// Plain compares, which compile to single instructions where fminf and
+// fmaxf are library calls
+
+#define PICK_MIN(A, B) ((A) < (B) ? (A) : (B))
+#define PICK_MAX(A, B) ((A) > (B) ? (A) : (B))
+
+// Types
+
+// One triangle per lane: its first vertex and the two edges from it.
+// Unused lanes have zero edges, which no ray hits.
+
+typedef struct {
+    float X[PICK_WIDTH];
+    float Y[PICK_WIDTH];
+    float Z[PICK_WIDTH];
+    float Edge1X[PICK_WIDTH];
+    float Edge1Y[PICK_WIDTH];
+    float Edge1Z[PICK_WIDTH];
+    float Edge2X[PICK_WIDTH];
+    float Edge2Y[PICK_WIDTH];
+    float Edge2Z[PICK_WIDTH];
+} pickPack;
+
+typedef struct {
+    pickPack* Packs;
+    int PackCount;
+    int TriangleCount;
+    v3 Min;
+    v3 Max;
+} pickMesh;
+
+typedef struct {
+    pickMesh* Mesh;
+    matrix Model;
+    matrix Inverse;
+    v3 Min;
+    v3 Max;
+} pickInstance;
+
+// An instance's world box, copied next to the others so building the
+// hierarchy reads them in order
+
+typedef struct {
+    v3 Min;
+    v3 Max;
+    int Instance;
+} pickItem;
+
+// Children of an inner node are the two nodes from First, a leaf holds
+// Count instances from Items[First]
+
+typedef struct {
+    v3 Min;
+    v3 Max;
+    int First;
+    int Count;
+} pickNode;
+
+typedef struct {
+    pickInstance* Instances;
+    pickItem* Items;
+    pickNode* Nodes;
+    int InstanceCount;
+    int NodeCount;
+} pickScene;
+
+// Distance along the ray and barycentrics of the nearest hit: the point is
+// A + U * (B - A) + V * (C - A) of the triangle. Distances are in lengths
+// of the ray's direction, which an instance's model matrix doesn't change.
+
+typedef struct {
+    float T;
+    float U;
+    float V;
+    int Triangle;
+    int Instance;
+} pickHit;
+
+// Declarations
+
+int RayTriangleIntersect(v3 RayOrigin, v3 RayDirection, triangle* Triangle);
+
+void PickMouseRay(int MouseX, int MouseY, int Width, int Height, matrix* Projection, matrix* InverseView, v3* Origin, v3* Direction);
+int PickRayPlane(v3 Origin, v3 Direction, float Z, v3* Hit);
+
+size_t PickMeshMemorySize(int TriangleCount);
+void PickMeshInit(pickMesh* Mesh, void* Memory, float* Vertices, int TriangleCount, int Stride);
+int PickMeshRay(pickMesh* Mesh, v3 Origin, v3 Direction, pickHit* Hit);
+int PickPackRay(pickPack* Pack, v3 Origin, v3 Direction, float* T, float* U, float* V);
+
+size_t PickSceneMemorySize(int InstanceCount);
+void PickSceneInit(pickScene* Scene, void* Memory, int InstanceCount);
+void PickSceneSet(pickScene* Scene, int Instance, pickMesh* Mesh, matrix* Model);
+void PickSceneBuild(pickScene* Scene);
+int PickSceneRay(pickScene* Scene, v3 Origin, v3 Direction, pickHit* Hit);
+
+void PickSceneSplit(pickScene* Scene, int Node, int First, int Count);
+void PickSceneSelect(pickScene* Scene, int First, int Count, int Nth, int Axis);
+float PickCenter(pickScene* Scene, int Index, int Axis);
+int PickBoxRay(v3 Min, v3 Max, v3 Origin, v3 Inverse, float Far, float* Near);
+
+// Functions
+
+/*
+Möller–Trumbore intersection algorithm
+https://en.wikipedia.org/wiki/M%C3%B6ller%E2%80%93Trumbore_intersection_algorithm
+*/
+int RayTriangleIntersect(v3 RayOrigin, v3 RayDirection, triangle* Triangle) {
+    const float EPSILON = 0.0000001f;
+    v3 Vertex0 = Triangle->A;
+    v3 Vertex1 = Triangle->B;
+    v3 Vertex2 = Triangle->C;
+    v3 Edge1, Edge2, H, S, Q;
+    float A, F, U, V;
+    Edge1 = V3Subtract(Vertex1, Vertex0);
+    Edge2 = V3Subtract(Vertex2, Vertex0);
+    H = V3CrossProduct(RayDirection, Edge2);
+    A = V3DotProduct(Edge1, H);
+    if(A > -EPSILON && A < EPSILON) return 0;
+    F = 1.0f / A;
+    S = V3Subtract(RayOrigin, Vertex0);
+    U = F * V3DotProduct(S, H);
+    if(U < 0.0f || U > 1.0f) return 0;
+    Q = V3CrossProduct(S, Edge1);
+    V = F * V3DotProduct(RayDirection, Q);
+    if(V < 0.0f || ((U + V) > 1.0f)) return 0;
+    float T = F * V3DotProduct(Edge2, Q);
+    if(T > EPSILON) return 1;
+    return 0;
+}
+
+// Ray from a camera through a point of a Width by Height client area, in
+// world space. Projection scales x and y only, as a perspective one does.
+
+void PickMouseRay(int MouseX, int MouseY, int Width, int Height, matrix* Projection, matrix* InverseView, v3* Origin, v3* Direction) {
+    
+    float X = ((2.0f * (float)MouseX) / (float)Width) - 1.0f;
+    float Y = (((2.0f * (float)MouseY) / (float)Height) - 1.0f) * -1.0f;
+    
+    X = X / Projection->M[0][0];
+    Y = Y / Projection->M[1][1];
+    
+    Direction->X = X * InverseView->M[0][0] + Y * InverseView->M[1][0] + InverseView->M[2][0];
+    Direction->Y = X * InverseView->M[0][1] + Y * InverseView->M[1][1] + InverseView->M[2][1];
+    Direction->Z = X * InverseView->M[0][2] + Y * InverseView->M[1][2] + InverseView->M[2][2];
+    
+    *Origin = (v3){InverseView->M[3][0], InverseView->M[3][1], InverseView->M[3][2]};
+}
+
+// Point where the ray meets the plane at height Z, if it is in front of
+// the origin. Same limits as RayTriangleIntersect on a triangle facing the
+// ray.
+
+int PickRayPlane(v3 Origin, v3 Direction, float Z, v3* Hit) {
+    
+    V3Normalize(&Direction);
+    if(Direction.Z > -PICK_EPSILON && Direction.Z < PICK_EPSILON) return 0;
+    
+    float T = (Z - Origin.Z) / Direction.Z;
+    if(T <= PICK_EPSILON) return 0;
+    
+    Hit->X = Origin.X + T * Direction.X;
+    Hit->Y = Origin.Y + T * Direction.Y;
+    Hit->Z = Z;
+    return 1;
+}
+
+size_t PickMeshMemorySize(int TriangleCount) {
+    return (size_t)((TriangleCount + PICK_WIDTH - 1) / PICK_WIDTH) * sizeof(pickPack);
+}
+
+// Vertices is a triangle list, Stride floats per vertex with the position
+// first, as the vertex buffers are laid out
+
+void PickMeshInit(pickMesh* Mesh, void* Memory, float* Vertices, int TriangleCount, int Stride) {
+    
+    Mesh->Packs = (pickPack*)Memory;
+    Mesh->PackCount = (TriangleCount + PICK_WIDTH - 1) / PICK_WIDTH;
+    Mesh->TriangleCount = TriangleCount;
+    Mesh->Min = (v3){FLT_MAX, FLT_MAX, FLT_MAX};
+    Mesh->Max = (v3){-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    memset(Mesh->Packs, 0, PickMeshMemorySize(TriangleCount));
+    
+    for(int Triangle = 0; Triangle < TriangleCount; ++Triangle) {
+        
+        v3 Corners[3];
+        for(int Corner = 0; Corner < 3; ++Corner) {
+            float* Vertex = &Vertices[(Triangle * 3 + Corner) * Stride];
+            Corners[Corner] = (v3){Vertex[0], Vertex[1], Vertex[2]};
+            
+            Mesh->Min.X = PICK_MIN(Mesh->Min.X, Vertex[0]);
+            Mesh->Min.Y = PICK_MIN(Mesh->Min.Y, Vertex[1]);
+            Mesh->Min.Z = PICK_MIN(Mesh->Min.Z, Vertex[2]);
+            Mesh->Max.X = PICK_MAX(Mesh->Max.X, Vertex[0]);
+            Mesh->Max.Y = PICK_MAX(Mesh->Max.Y, Vertex[1]);
+            Mesh->Max.Z = PICK_MAX(Mesh->Max.Z, Vertex[2]);
+        }
+        
+        v3 Edge1 = V3Subtract(Corners[1], Corners[0]);
+        v3 Edge2 = V3Subtract(Corners[2], Corners[0]);
+        
+        pickPack* Pack = &Mesh->Packs[Triangle / PICK_WIDTH];
+        int Lane = Triangle % PICK_WIDTH;
+        Pack->X[Lane] = Corners[0].X;
+        Pack->Y[Lane] = Corners[0].Y;
+        Pack->Z[Lane] = Corners[0].Z;
+        Pack->Edge1X[Lane] = Edge1.X;
+        Pack->Edge1Y[Lane] = Edge1.Y;
+        Pack->Edge1Z[Lane] = Edge1.Z;
+        Pack->Edge2X[Lane] = Edge2.X;
+        Pack->Edge2Y[Lane] = Edge2.Y;
+        Pack->Edge2Z[Lane] = Edge2.Z;
+    }
+}
+
+// Tests every triangle of a pack, in the same order of operations as
+// RayTriangleIntersect so both agree on the edges. Returns a mask of the
+// lanes hit, with their distances and barycentrics in T, U and V.
+
+#if defined(PICK_AVX) || defined(PICK_SSE)
+
+#ifdef PICK_AVX
+typedef __m256 pickLanes;
+#define PICK_LOAD(Pointer) _mm256_loadu_ps(Pointer)
+#define PICK_STORE(Pointer, A) _mm256_storeu_ps(Pointer, A)
+#define PICK_SET(A) _mm256_set1_ps(A)
+#define PICK_ADD(A, B) _mm256_add_ps(A, B)
+#define PICK_SUB(A, B) _mm256_sub_ps(A, B)
+#define PICK_MUL(A, B) _mm256_mul_ps(A, B)
+#define PICK_DIV(A, B) _mm256_div_ps(A, B)
+#define PICK_AND(A, B) _mm256_and_ps(A, B)
+#define PICK_OR(A, B) _mm256_or_ps(A, B)
+#define PICK_GREATER(A, B) _mm256_cmp_ps(A, B, _CMP_GT_OQ)
+#define PICK_LESS_EQUAL(A, B) _mm256_cmp_ps(A, B, _CMP_LE_OQ)
+#define PICK_GREATER_EQUAL(A, B) _mm256_cmp_ps(A, B, _CMP_GE_OQ)
+#define PICK_MASK(A) _mm256_movemask_ps(A)
+#else
+typedef __m128 pickLanes;
+#define PICK_LOAD(Pointer) _mm_loadu_ps(Pointer)
+#define PICK_STORE(Pointer, A) _mm_storeu_ps(Pointer, A)
+#define PICK_SET(A) _mm_set1_ps(A)
+#define PICK_ADD(A, B) _mm_add_ps(A, B)
+#define PICK_SUB(A, B) _mm_sub_ps(A, B)
+#define PICK_MUL(A, B) _mm_mul_ps(A, B)
+#define PICK_DIV(A, B) _mm_div_ps(A, B)
+#define PICK_AND(A, B) _mm_and_ps(A, B)
+#define PICK_OR(A, B) _mm_or_ps(A, B)
+#define PICK_GREATER(A, B) _mm_cmpgt_ps(A, B)
+#define PICK_LESS_EQUAL(A, B) _mm_cmple_ps(A, B)
+#define PICK_GREATER_EQUAL(A, B) _mm_cmpge_ps(A, B)
+#define PICK_MASK(A) _mm_movemask_ps(A)
+#endif
+
+int PickPackRay(pickPack* Pack, v3 Origin, v3 Direction, float* T, float* U, float* V) {
+    
+    pickLanes DirectionX = PICK_SET(Direction.X);
+    pickLanes DirectionY = PICK_SET(Direction.Y);
+    pickLanes DirectionZ = PICK_SET(Direction.Z);
+    pickLanes Edge1X = PICK_LOAD(Pack->Edge1X);
+    pickLanes Edge1Y = PICK_LOAD(Pack->Edge1Y);
+    pickLanes Edge1Z = PICK_LOAD(Pack->Edge1Z);
+    pickLanes Edge2X = PICK_LOAD(Pack->Edge2X);
+    pickLanes Edge2Y = PICK_LOAD(Pack->Edge2Y);
+    pickLanes Edge2Z = PICK_LOAD(Pack->Edge2Z);
+    
+    // H = Direction x Edge2, A = Edge1 . H
+    
+    pickLanes HX = PICK_SUB(PICK_MUL(DirectionY, Edge2Z), PICK_MUL(DirectionZ, Edge2Y));
+    pickLanes HY = PICK_SUB(PICK_MUL(DirectionZ, Edge2X), PICK_MUL(DirectionX, Edge2Z));
+    pickLanes HZ = PICK_SUB(PICK_MUL(DirectionX, Edge2Y), PICK_MUL(DirectionY, Edge2X));
+    pickLanes A = PICK_ADD(PICK_ADD(PICK_MUL(Edge1X, HX), PICK_MUL(Edge1Y, HY)), PICK_MUL(Edge1Z, HZ));
+    pickLanes Hit = PICK_OR(PICK_LESS_EQUAL(A, PICK_SET(-PICK_EPSILON)), PICK_GREATER_EQUAL(A, PICK_SET(PICK_EPSILON)));
+    pickLanes F = PICK_DIV(PICK_SET(1.0f), A);
+    
+    // S = Origin - Vertex0, U = F * (S . H)
+    
+    pickLanes SX = PICK_SUB(PICK_SET(Origin.X), PICK_LOAD(Pack->X));
+    pickLanes SY = PICK_SUB(PICK_SET(Origin.Y), PICK_LOAD(Pack->Y));
+    pickLanes SZ = PICK_SUB(PICK_SET(Origin.Z), PICK_LOAD(Pack->Z));
+    pickLanes LanesU = PICK_MUL(F, PICK_ADD(PICK_ADD(PICK_MUL(SX, HX), PICK_MUL(SY, HY)), PICK_MUL(SZ, HZ)));
+    Hit = PICK_AND(Hit, PICK_AND(PICK_GREATER_EQUAL(LanesU, PICK_SET(0.0f)), PICK_LESS_EQUAL(LanesU, PICK_SET(1.0f))));
+    
+    // Q = S x Edge1, V = F * (Direction . Q), T = F * (Edge2 . Q)
+    
+    pickLanes QX = PICK_SUB(PICK_MUL(SY, Edge1Z), PICK_MUL(SZ, Edge1Y));
+    pickLanes QY = PICK_SUB(PICK_MUL(SZ, Edge1X), PICK_MUL(SX, Edge1Z));
+    pickLanes QZ = PICK_SUB(PICK_MUL(SX, Edge1Y), PICK_MUL(SY, Edge1X));
+    pickLanes LanesV = PICK_MUL(F, PICK_ADD(PICK_ADD(PICK_MUL(DirectionX, QX), PICK_MUL(DirectionY, QY)), PICK_MUL(DirectionZ, QZ)));
+    Hit = PICK_AND(Hit, PICK_AND(PICK_GREATER_EQUAL(LanesV, PICK_SET(0.0f)), PICK_LESS_EQUAL(PICK_ADD(LanesU, LanesV), PICK_SET(1.0f))));
+    
+    pickLanes LanesT = PICK_MUL(F, PICK_ADD(PICK_ADD(PICK_MUL(Edge2X, QX), PICK_MUL(Edge2Y, QY)), PICK_MUL(Edge2Z, QZ)));
+    Hit = PICK_AND(Hit, PICK_GREATER(LanesT, PICK_SET(PICK_EPSILON)));
+    
+    PICK_STORE(T, LanesT);
+    PICK_STORE(U, LanesU);
+    PICK_STORE(V, LanesV);
+    return PICK_MASK(Hit);
+}
+
+#else
+
+int PickPackRay(pickPack* Pack, v3 Origin, v3 Direction, float* T, float* U, float* V) {
+    
+    int Mask = 0;
+    for(int Lane = 0; Lane < PICK_WIDTH; ++Lane) {
+        
+        v3 Edge1 = {Pack->Edge1X[Lane], Pack->Edge1Y[Lane], Pack->Edge1Z[Lane]};
+        v3 Edge2 = {Pack->Edge2X[Lane], Pack->Edge2Y[Lane], Pack->Edge2Z[Lane]};
+        v3 H = V3CrossProduct(Direction, Edge2);
+        float A = V3DotProduct(Edge1, H);
+        if(A > -PICK_EPSILON && A < PICK_EPSILON) continue;
+        
+        float F = 1.0f / A;
+        v3 S = V3Subtract(Origin, (v3){Pack->X[Lane], Pack->Y[Lane], Pack->Z[Lane]});
+        U[Lane] = F * V3DotProduct(S, H);
+        if(U[Lane] < 0.0f || U[Lane] > 1.0f) continue;
+        
+        v3 Q = V3CrossProduct(S, Edge1);
+        V[Lane] = F * V3DotProduct(Direction, Q);
+        if(V[Lane] < 0.0f || U[Lane] + V[Lane] > 1.0f) continue;
+        
+        T[Lane] = F * V3DotProduct(Edge2, Q);
+        if(T[Lane] > PICK_EPSILON) {
+            Mask |= 1 << Lane;
+        }
+    }
+    return Mask;
+}
+
+#endif
+
+// Nearest triangle the ray hits closer than Hit->T, which the caller sets
+// to how far to look, FLT_MAX for any distance. Returns 0 and leaves Hit
+// alone if there is none.
+
+int PickMeshRay(pickMesh* Mesh, v3 Origin, v3 Direction, pickHit* Hit) {
+    
+    int Result = 0;
+    float T[PICK_WIDTH], U[PICK_WIDTH], V[PICK_WIDTH];
+    
+    for(int Index = 0; Index < Mesh->PackCount; ++Index) {
+        
+        int Mask = PickPackRay(&Mesh->Packs[Index], Origin, Direction, T, U, V);
+        
+        // Lanes in order, so the first of equally near triangles wins
+        
+        while(Mask) {
+            int Lane = 0;
+            while(!(Mask & (1 << Lane))) {
+                ++Lane;
+            }
+            Mask &= Mask - 1;
+            
+            if(T[Lane] < Hit->T) {
+                Hit->T = T[Lane];
+                Hit->U = U[Lane];
+                Hit->V = V[Lane];
+                Hit->Triangle = Index * PICK_WIDTH + Lane;
+                Result = 1;
+            }
+        }
+    }
+    return Result;
+}
+
+// A hierarchy over N instances has at most 2N - 1 nodes
+
+size_t PickSceneMemorySize(int InstanceCount) {
+    return (size_t)InstanceCount * (sizeof(pickInstance) + sizeof(pickItem) + 2 * sizeof(pickNode));
+}
+
+// Memory starts on 16 bytes, for the instances' matrices
+
+void PickSceneInit(pickScene* Scene, void* Memory, int InstanceCount) {
+    
+    unsigned char* Data = (unsigned char*)Memory;
+    memset(Data, 0, PickSceneMemorySize(InstanceCount));
+    
+    Scene->Instances = (pickInstance*)Data;
+    Data += (size_t)InstanceCount * sizeof(pickInstance);
+    Scene->Nodes = (pickNode*)Data;
+    Data += (size_t)InstanceCount * 2 * sizeof(pickNode);
+    Scene->Items = (pickItem*)Data;
+    
+    Scene->InstanceCount = InstanceCount;
+    Scene->NodeCount = 0;
+}
+
+// Places Mesh in the world with Model. The hierarchy is stale until the
+// next PickSceneBuild.
+
+void PickSceneSet(pickScene* Scene, int Instance, pickMesh* Mesh, matrix* Model) {
+    
+    pickInstance* Placed = &Scene->Instances[Instance];
+    Placed->Mesh = Mesh;
+    Placed->Model = *Model;
+    MatrixInverse(Model, &Placed->Inverse);
+    
+    // World box around the corners of the mesh's box
+    
+    Placed->Min = (v3){FLT_MAX, FLT_MAX, FLT_MAX};
+    Placed->Max = (v3){-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    
+    for(int Corner = 0; Corner < 8; ++Corner) {
+        v3 Point = {
+            Corner & 1 ? Mesh->Max.X : Mesh->Min.X,
+            Corner & 2 ? Mesh->Max.Y : Mesh->Min.Y,
+            Corner & 4 ? Mesh->Max.Z : Mesh->Min.Z,
+        };
+        Point = V3TransformCoord(&Point, Model);
+        
+        Placed->Min.X = PICK_MIN(Placed->Min.X, Point.X);
+        Placed->Min.Y = PICK_MIN(Placed->Min.Y, Point.Y);
+        Placed->Min.Z = PICK_MIN(Placed->Min.Z, Point.Z);
+        Placed->Max.X = PICK_MAX(Placed->Max.X, Point.X);
+        Placed->Max.Y = PICK_MAX(Placed->Max.Y, Point.Y);
+        Placed->Max.Z = PICK_MAX(Placed->Max.Z, Point.Z);
+    }
+}
+
+void PickSceneBuild(pickScene* Scene) {
+    
+    for(int Index = 0; Index < Scene->InstanceCount; ++Index) {
+        pickInstance* Instance = &Scene->Instances[Index];
+        Scene->Items[Index] = (pickItem){Instance->Min, Instance->Max, Index};
+    }
+    
+    Scene->NodeCount = 1;
+    if(Scene->InstanceCount > 0) {
+        PickSceneSplit(Scene, 0, 0, Scene->InstanceCount);
+    } else {
+        Scene->NodeCount = 0;
+    }
+}
+
+// Bounds Node around Items[First] to Items[First + Count - 1], and splits
+// them in two until leaves are small
+
+void PickSceneSplit(pickScene* Scene, int Node, int First, int Count) {
+    
+    pickNode* Bounds = &Scene->Nodes[Node];
+    Bounds->Min = (v3){FLT_MAX, FLT_MAX, FLT_MAX};
+    Bounds->Max = (v3){-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    v3 CenterMin = Bounds->Min;
+    v3 CenterMax = Bounds->Max;
+    
+    for(int Index = First; Index < First + Count; ++Index) {
+        
+        pickItem* Item = &Scene->Items[Index];
+        Bounds->Min.X = PICK_MIN(Bounds->Min.X, Item->Min.X);
+        Bounds->Min.Y = PICK_MIN(Bounds->Min.Y, Item->Min.Y);
+        Bounds->Min.Z = PICK_MIN(Bounds->Min.Z, Item->Min.Z);
+        Bounds->Max.X = PICK_MAX(Bounds->Max.X, Item->Max.X);
+        Bounds->Max.Y = PICK_MAX(Bounds->Max.Y, Item->Max.Y);
+        Bounds->Max.Z = PICK_MAX(Bounds->Max.Z, Item->Max.Z);
+        
+        v3 Center = V3MultiplyScalar(V3Add(Item->Min, Item->Max), 0.5f);
+        CenterMin.X = PICK_MIN(CenterMin.X, Center.X);
+        CenterMin.Y = PICK_MIN(CenterMin.Y, Center.Y);
+        CenterMin.Z = PICK_MIN(CenterMin.Z, Center.Z);
+        CenterMax.X = PICK_MAX(CenterMax.X, Center.X);
+        CenterMax.Y = PICK_MAX(CenterMax.Y, Center.Y);
+        CenterMax.Z = PICK_MAX(CenterMax.Z, Center.Z);
+    }
+    
+    if(Count <= PICK_LEAF_SIZE) {
+        Bounds->First = First;
+        Bounds->Count = Count;
+        return;
+    }
+    
+    // Half the instances on each side of the median along the longest axis
+    // of their centers, which keeps the hierarchy balanced
+    
+    v3 Extent = V3Subtract(CenterMax, CenterMin);
+    int Axis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : Extent.Y >= Extent.Z ? 1 : 2;
+    int LeftCount = Count / 2;
+    PickSceneSelect(Scene, First, Count, LeftCount, Axis);
+    
+    int Child = Scene->NodeCount;
+    Scene->NodeCount += 2;
+    Bounds->First = Child;
+    Bounds->Count = 0;
+    
+    PickSceneSplit(Scene, Child, First, LeftCount);
+    PickSceneSplit(Scene, Child + 1, First + LeftCount, Count - LeftCount);
+}
+
+float PickCenter(pickScene* Scene, int Index, int Axis) {
+    pickItem* Item = &Scene->Items[Index];
+    return ((&Item->Min.X)[Axis] + (&Item->Max.X)[Axis]) * 0.5f;
+}
+
+// Reorders Items[First] to Items[First + Count - 1] so the Nth has the Nth
+// smallest center along Axis, none before it larger and none after smaller
+
+void PickSceneSelect(pickScene* Scene, int First, int Count, int Nth, int Axis) {
+    
+    pickItem* Items = Scene->Items;
+    int Low = First;
+    int High = First + Count - 1;
+    Nth += First;
+    
+    while(Low < High) {
+        
+        float Pivot = PickCenter(Scene, (Low + High) / 2, Axis);
+        int Left = Low;
+        int Right = High;
+        
+        while(Left <= Right) {
+            while(PickCenter(Scene, Left, Axis) < Pivot) ++Left;
+            while(PickCenter(Scene, Right, Axis) > Pivot) --Right;
+            if(Left <= Right) {
+                pickItem Swap = Items[Left];
+                Items[Left++] = Items[Right];
+                Items[Right--] = Swap;
+            }
+        }
+        
+        if(Nth <= Right) {
+            High = Right;
+        } else if(Nth >= Left) {
+            Low = Left;
+        } else {
+            break;
+        }
+    }
+}
+
+// Slab test, with Inverse holding 1 / Direction. A ray in the plane of a
+// slab's face makes a NaN there, and which way that test goes doesn't
+// matter: the ray is parallel to any triangle on that face.
+
+int PickBoxRay(v3 Min, v3 Max, v3 Origin, v3 Inverse, float Far, float* Near) {
+    
+    float X0 = (Min.X - Origin.X) * Inverse.X, X1 = (Max.X - Origin.X) * Inverse.X;
+    float Y0 = (Min.Y - Origin.Y) * Inverse.Y, Y1 = (Max.Y - Origin.Y) * Inverse.Y;
+    float Z0 = (Min.Z - Origin.Z) * Inverse.Z, Z1 = (Max.Z - Origin.Z) * Inverse.Z;
+    
+    float Enter = PICK_MAX(PICK_MAX(PICK_MIN(X0, X1), PICK_MIN(Y0, Y1)), PICK_MAX(PICK_MIN(Z0, Z1), 0.0f));
+    float Exit = PICK_MIN(PICK_MIN(PICK_MAX(X0, X1), PICK_MAX(Y0, Y1)), PICK_MIN(PICK_MAX(Z0, Z1), Far));
+    
+    *Near = Enter;
+    return Enter <= Exit;
+}
+
+// Nearest triangle of any instance the ray hits closer than Hit->T, as in
+// PickMeshRay, with the instance in Hit->Instance
+
+int PickSceneRay(pickScene* Scene, v3 Origin, v3 Direction, pickHit* Hit) {
+    
+    if(Scene->NodeCount == 0) {
+        return 0;
+    }
+    
+    int Result = 0;
+    v3 Inverse = {1.0f / Direction.X, 1.0f / Direction.Y, 1.0f / Direction.Z};
+    
+    // Boxes to visit, with where the ray enters them. One behind the
+    // nearest hit so far is skipped, here or when popped after a nearer hit
+    
+    int Stack[PICK_STACK_SIZE];
+    float StackNear[PICK_STACK_SIZE];
+    int StackCount = 0;
+    float Near;
+    
+    if(PickBoxRay(Scene->Nodes[0].Min, Scene->Nodes[0].Max, Origin, Inverse, Hit->T, &Near)) {
+        Stack[StackCount] = 0;
+        StackNear[StackCount++] = Near;
+    }
+    
+    while(StackCount > 0) {
+        
+        --StackCount;
+        if(StackNear[StackCount] >= Hit->T) {
+            continue;
+        }
+        pickNode* Node = &Scene->Nodes[Stack[StackCount]];
+        
+        if(Node->Count > 0) {
+            for(int Index = Node->First; Index < Node->First + Node->Count; ++Index) {
+                
+                pickInstance* Instance = &Scene->Instances[Scene->Items[Index].Instance];
+                v3 ModelOrigin = V3TransformCoord(&Origin, &Instance->Inverse);
+                v3 ModelDirection = V3TransformNormal(&Direction, &Instance->Inverse);
+                
+                if(PickMeshRay(Instance->Mesh, ModelOrigin, ModelDirection, Hit)) {
+                    Hit->Instance = Scene->Items[Index].Instance;
+                    Result = 1;
+                }
+            }
+            continue;
+        }
+        
+        // Nearer child on top
+        
+        float ChildNear[2];
+        int Hits[2];
+        for(int Side = 0; Side < 2; ++Side) {
+            pickNode* Child = &Scene->Nodes[Node->First + Side];
+            Hits[Side] = PickBoxRay(Child->Min, Child->Max, Origin, Inverse, Hit->T, &ChildNear[Side]);
+        }
+        
+        int Nearer = ChildNear[1] < ChildNear[0];
+        for(int Side = 0; Side < 2; ++Side) {
+            int Child = Side ? Nearer : !Nearer;
+            if(Hits[Child]) {
+                Stack[StackCount] = Node->First + Child;
+                StackNear[StackCount++] = ChildNear[Child];
+            }
+        }
+    }
+    return Result;
+}
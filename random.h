@@ -0,0 +1,120 @@
+// Seedable random numbers, independent of the C library's global rand()
+//
+// xoshiro256** (Blackman and Vigna), seeded through splitmix64 so any 64
+// bit seed, including 0, gives a usable state. Every board owns one, so a
+// board is reproducible from its seed and boards can be generated on
+// several threads at once.
+#include <string.h>
+
+// Types
+
+typedef struct {
+    unsigned long long State[4];
+} rng;
+
+// Declarations
+
+void RngSeed(rng* Random, unsigned long long Seed);
+unsigned long long RngNext(rng* Random);
+unsigned int RngBelow(rng* Random, unsigned int Bound);
+void RngJump(rng* Random);
+rng RngSplit(rng* Random);
+unsigned long long SplitMix64(unsigned long long* Value);
+unsigned long long RngHash(unsigned long long Seed, unsigned long long Counter);
+unsigned long long RotateLeft(unsigned long long Value, int Bits);
+
+// Functions
+
+unsigned long long SplitMix64(unsigned long long* Value) {
+    unsigned long long Z = (*Value += 0x9E3779B97F4A7C15ull);
+    Z = (Z ^ (Z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    Z = (Z ^ (Z >> 27)) * 0x94D049BB133111EBull;
+    return Z ^ (Z >> 31);
+}
+
+// Counter based numbers: a different, unrelated number for every seed and
+// counter pair, with no state to carry from one to the next
+
+unsigned long long RngHash(unsigned long long Seed, unsigned long long Counter) {
+    unsigned long long Value = Seed ^ RotateLeft(Counter * 0xD1B54A32D192ED03ull, 29);
+    return SplitMix64(&Value);
+}
+
+unsigned long long RotateLeft(unsigned long long Value, int Bits) {
+    return (Value << Bits) | (Value >> (64 - Bits));
+}
+
+void RngSeed(rng* Random, unsigned long long Seed) {
+    for(int Index = 0; Index < 4; ++Index) {
+        Random->State[Index] = SplitMix64(&Seed);
+    }
+}
+
+unsigned long long RngNext(rng* Random) {
+    
+    unsigned long long* S = Random->State;
+    unsigned long long Result = RotateLeft(S[1] * 5, 7) * 9;
+    unsigned long long T = S[1] << 17;
+    
+    S[2] ^= S[0];
+    S[3] ^= S[1];
+    S[1] ^= S[2];
+    S[0] ^= S[3];
+    S[2] ^= T;
+    S[3] = RotateLeft(S[3], 45);
+    
+    return Result;
+}
+
+// Random number from 0 to Bound - 1 without modulo bias (Lemire's
+// multiply and shift, redrawing only the rare values that would skew it)
+
+unsigned int RngBelow(rng* Random, unsigned int Bound) {
+    
+    unsigned long long Product = (RngNext(Random) >> 32) * Bound;
+    unsigned int Low = (unsigned int)Product;
+    
+    if(Low < Bound) {
+        unsigned int Threshold = (0u - Bound) % Bound;
+        while(Low < Threshold) {
+            Product = (RngNext(Random) >> 32) * Bound;
+            Low = (unsigned int)Product;
+        }
+    }
+    
+    return (unsigned int)(Product >> 32);
+}
+
+// Advances the state by 2^128 numbers
+
+void RngJump(rng* Random) {
+    
+    static const unsigned long long Jump[] = {
+        0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull, 0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull,
+    };
+    
+    unsigned long long S[4] = {0};
+    
+    for(int Index = 0; Index < 4; ++Index) {
+        for(int Bit = 0; Bit < 64; ++Bit) {
+            if(Jump[Index] & (1ull << Bit)) {
+                S[0] ^= Random->State[0];
+                S[1] ^= Random->State[1];
+                S[2] ^= Random->State[2];
+                S[3] ^= Random->State[3];
+            }
+            RngNext(Random);
+        }
+    }
+    
+    memcpy(Random->State, S, sizeof(S));
+}
+
+// Returns a generator for another user, such as a thread, and jumps this
+// one past the 2^128 numbers that now belong to it, so the two never overlap
+
+rng RngSplit(rng* Random) {
+    rng Split = *Random;
+    RngJump(Random);
+    return Split;
+}
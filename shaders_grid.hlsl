@@ -1,11 +1,14 @@
 cbuffer constants : register(b0)
 {
     row_major float4x4 model;
-    row_major float4x4 view;
-    row_major float4x4 projection;
     float4 color;
 };
 
+cbuffer frame : register(b1)
+{
+    row_major float4x4 view_projection;
+};
+
 struct VS_Input
 {
 	float3 position: POSITION;
@@ -20,7 +23,7 @@ struct VS_Output
 VS_Output vs_main(VS_Input input)
 {
 	VS_Output output;
-	output.position = mul(float4(input.position, 1.0f), mul(mul(model, view), projection));
+	output.position = mul(mul(float4(input.position, 1.0f), model), view_projection);
 	output.color = color;
 	return output;
 };
@@ -0,0 +1,414 @@
+// Infinite board, made of chunks that exist only where the player has been
+//
+// The world is split into CHUNK_SIZE square chunks kept in a hash map by
+// chunk coordinates. A chunk is made the first time one of its tiles is
+// revealed or flagged, so memory grows with the explored area only. Bombs
+// come from ChunkBombsByDensity, which depends on nothing but the seed and
+// the chunk's coordinates, so a chunk's numbers can be counted from its
+// neighbors' bombs without making the neighbors.
+
+#define WORLD_FLOOD_BUDGET 100000
+
+// Types
+
+typedef struct {
+    int X;
+    int Y;
+    unsigned long long Bombs[CHUNK_SIZE];
+    unsigned char Cells[CHUNK_SIZE * CHUNK_SIZE];
+} chunk;
+
+// Growable ring buffer of tile positions
+
+typedef struct {
+    point* Items;
+    int Capacity;
+    int First;
+    int Length;
+} tileQueue;
+
+// Slots is an open addressing table, a power of two long and at most half
+// full. A flood may be left unfinished in Frontier, see WorldFlood.
+
+typedef struct {
+    chunk** Slots;
+    int SlotCount;
+    int ChunkCount;
+    tileQueue Frontier;
+    unsigned long long Seed;
+    unsigned int Density;
+    point FirstPick;
+    long long RevealedCount;
+    int Flags;
+    int Playing;
+    int Picked;
+} world;
+
+// Declarations
+
+void WorldNewGame(world* World, unsigned int Density, unsigned long long Seed);
+void WorldFree(world* World);
+void WorldReveal(world* World, int X, int Y);
+void WorldFlag(world* World, int X, int Y);
+void WorldChord(world* World, int X, int Y);
+int WorldFlood(world* World, int Budget);
+
+tile WorldGetTile(world* World, int X, int Y);
+int WorldGetType(world* World, int X, int Y);
+
+chunk* WorldFindChunk(world* World, int ChunkX, int ChunkY);
+chunk* WorldGetChunk(world* World, int ChunkX, int ChunkY);
+chunk* WorldTileChunk(world* World, int X, int Y);
+void WorldChunkBombs(world* World, int ChunkX, int ChunkY, unsigned long long* Rows);
+void WorldFillChunk(world* World, chunk* Chunk);
+void WorldGrow(world* World);
+int WorldSlot(world* World, int ChunkX, int ChunkY);
+int WorldVisit(world* World, int X, int Y);
+unsigned char* WorldCell(world* World, int X, int Y);
+size_t WorldMemorySize(world* World);
+
+void TileQueueAdd(tileQueue* Queue, point Position);
+point TileQueuePop(tileQueue* Queue);
+
+// Functions
+
+void TileQueueAdd(tileQueue* Queue, point Position) {
+    
+    // Double and unwrap when full
+    
+    if(Queue->Length == Queue->Capacity) {
+        int Capacity = Queue->Capacity ? Queue->Capacity * 2 : 1024;
+        point* Items = malloc(Capacity * sizeof(*Items));
+        assert(Items);
+        for(int Index = 0; Index < Queue->Length; ++Index) {
+            Items[Index] = Queue->Items[(Queue->First + Index) % Queue->Capacity];
+        }
+        free(Queue->Items);
+        Queue->Items = Items;
+        Queue->Capacity = Capacity;
+        Queue->First = 0;
+    }
+    
+    Queue->Items[(Queue->First + Queue->Length) % Queue->Capacity] = Position;
+    ++Queue->Length;
+}
+
+point TileQueuePop(tileQueue* Queue) {
+    point Position = Queue->Items[Queue->First];
+    Queue->First = (Queue->First + 1) % Queue->Capacity;
+    --Queue->Length;
+    return Position;
+}
+
+// Density is the chance of a bomb per tile, out of 2^32
+
+void WorldNewGame(world* World, unsigned int Density, unsigned long long Seed) {
+    
+    WorldFree(World);
+    
+    World->SlotCount = 64;
+    World->Slots = calloc(World->SlotCount, sizeof(*World->Slots));
+    assert(World->Slots);
+    
+    World->Seed = Seed;
+    World->Density = Density;
+    World->Playing = 1;
+}
+
+void WorldFree(world* World) {
+    for(int Slot = 0; Slot < World->SlotCount; ++Slot) {
+        free(World->Slots[Slot]);
+    }
+    free(World->Slots);
+    free(World->Frontier.Items);
+    memset(World, 0, sizeof(*World));
+}
+
+size_t WorldMemorySize(world* World) {
+    return World->ChunkCount * sizeof(chunk) +
+        World->SlotCount * sizeof(*World->Slots) +
+        World->Frontier.Capacity * sizeof(*World->Frontier.Items);
+}
+
+// Slot of the chunk, or of the empty slot where it would go
+
+int WorldSlot(world* World, int ChunkX, int ChunkY) {
+    
+    unsigned long long Hash = ChunkKey(ChunkX, ChunkY) * 0x9E3779B97F4A7C15ull;
+    int Mask = World->SlotCount - 1;
+    int Slot = (int)(Hash >> 40) & Mask;
+    
+    while(World->Slots[Slot] &&
+          (World->Slots[Slot]->X != ChunkX || World->Slots[Slot]->Y != ChunkY)) {
+        Slot = (Slot + 1) & Mask;
+    }
+    
+    return Slot;
+}
+
+void WorldGrow(world* World) {
+    
+    chunk** Slots = World->Slots;
+    int SlotCount = World->SlotCount;
+    
+    World->SlotCount *= 2;
+    World->Slots = calloc(World->SlotCount, sizeof(*World->Slots));
+    assert(World->Slots);
+    
+    for(int Slot = 0; Slot < SlotCount; ++Slot) {
+        if(Slots[Slot]) {
+            World->Slots[WorldSlot(World, Slots[Slot]->X, Slots[Slot]->Y)] = Slots[Slot];
+        }
+    }
+    
+    free(Slots);
+}
+
+chunk* WorldFindChunk(world* World, int ChunkX, int ChunkY) {
+    return World->Slots[WorldSlot(World, ChunkX, ChunkY)];
+}
+
+chunk* WorldGetChunk(world* World, int ChunkX, int ChunkY) {
+    
+    int Slot = WorldSlot(World, ChunkX, ChunkY);
+    if(World->Slots[Slot]) {
+        return World->Slots[Slot];
+    }
+    
+    if(2 * (World->ChunkCount + 1) > World->SlotCount) {
+        WorldGrow(World);
+        Slot = WorldSlot(World, ChunkX, ChunkY);
+    }
+    
+    chunk* Chunk = calloc(1, sizeof(*Chunk));
+    assert(Chunk);
+    Chunk->X = ChunkX;
+    Chunk->Y = ChunkY;
+    WorldFillChunk(World, Chunk);
+    
+    World->Slots[Slot] = Chunk;
+    ++World->ChunkCount;
+    
+    return Chunk;
+}
+
+// Tiles use arithmetic shifts, so negative coordinates round down to the
+// chunk on their left or above
+
+chunk* WorldTileChunk(world* World, int X, int Y) {
+    return WorldGetChunk(World, X >> 6, Y >> 6);
+}
+
+// Bombs of a chunk, with the first pick's 3x3 area kept clear
+
+void WorldChunkBombs(world* World, int ChunkX, int ChunkY, unsigned long long* Rows) {
+    
+    ChunkBombsByDensity(World->Seed, ChunkX, ChunkY, World->Density, Rows);
+    
+    if(!World->Picked) return;
+    
+    for(int Y = World->FirstPick.Y - 1; Y <= World->FirstPick.Y + 1; ++Y) {
+        for(int X = World->FirstPick.X - 1; X <= World->FirstPick.X + 1; ++X) {
+            if(X >> 6 == ChunkX && Y >> 6 == ChunkY) {
+                Rows[Y & 63] &= ~(1ull << (X & 63));
+            }
+        }
+    }
+}
+
+// Bombs and numbers of a chunk, keeping what was revealed and flagged. The
+// eight chunks around it only lend their bombs, laid out like a board's
+// padded bit plane so the same adder counts them.
+
+void WorldFillChunk(world* World, chunk* Chunk) {
+    
+    unsigned long long Plane[CHUNK_SIZE + 2][3];
+    unsigned long long Rows[CHUNK_SIZE];
+    
+    for(int ChunkY = -1; ChunkY <= 1; ++ChunkY) {
+        for(int ChunkX = -1; ChunkX <= 1; ++ChunkX) {
+            
+            WorldChunkBombs(World, Chunk->X + ChunkX, Chunk->Y + ChunkY, Rows);
+            
+            for(int Y = 0; Y < CHUNK_SIZE; ++Y) {
+                int PlaneY = Y + 1 + ChunkY * CHUNK_SIZE;
+                if(PlaneY >= 0 && PlaneY < CHUNK_SIZE + 2) {
+                    Plane[PlaneY][ChunkX + 1] = Rows[Y];
+                }
+            }
+        }
+    }
+    
+    unsigned long long Sum[4];
+    
+    for(int Y = 0; Y < CHUNK_SIZE; ++Y) {
+        Chunk->Bombs[Y] = Plane[Y + 1][1];
+        SumNeighbors(&Plane[Y][1], &Plane[Y + 1][1], &Plane[Y + 2][1], Sum);
+        for(int Bit = 0; Bit < 4; ++Bit) {
+            Sum[Bit] &= ~Chunk->Bombs[Y];
+        }
+        WriteCells(&Chunk->Cells[Y * CHUNK_SIZE], CHUNK_SIZE, Sum, Chunk->Bombs[Y]);
+    }
+}
+
+unsigned char* WorldCell(world* World, int X, int Y) {
+    return &WorldTileChunk(World, X, Y)->Cells[(Y & 63) * CHUNK_SIZE + (X & 63)];
+}
+
+int WorldGetType(world* World, int X, int Y) {
+    unsigned char Cell = *WorldCell(World, X, Y);
+    return Cell & CELL_BOMB ? BOMB : Cell & CELL_COUNT ? NUMBER : EMPTY;
+}
+
+// Tiles of chunks that were never made are hidden, and stay unmade. Only
+// bombs are shown once the game is lost, see WorldReveal.
+
+tile WorldGetTile(world* World, int X, int Y) {
+    
+    tile Tile = {0};
+    chunk* Chunk = WorldFindChunk(World, X >> 6, Y >> 6);
+    
+    if(Chunk) {
+        Tile = CellToTile(Chunk->Cells[(Y & 63) * CHUNK_SIZE + (X & 63)], 1);
+    }
+    
+    return Tile;
+}
+
+// Reveals a tile, returns 1 if it was hidden
+
+int WorldVisit(world* World, int X, int Y) {
+    unsigned char* Cell = WorldCell(World, X, Y);
+    if(*Cell & CELL_REVEALED) {
+        return 0;
+    }
+    *Cell |= CELL_REVEALED;
+    ++World->RevealedCount;
+    return 1;
+}
+
+// Opens up to Budget tiles of the flood in progress and returns how many
+// are left waiting. Below about 10% bombs the empty area of an infinite
+// board never ends, so a flood can't be run to completion in one go.
+
+int WorldFlood(world* World, int Budget) {
+    
+    for(; Budget > 0 && World->Frontier.Length > 0; --Budget) {
+        
+        point Current = TileQueuePop(&World->Frontier);
+        
+        for(int Y = Current.Y - 1; Y <= Current.Y + 1; ++Y) {
+            for(int X = Current.X - 1; X <= Current.X + 1; ++X) {
+                if(WorldVisit(World, X, Y) && WorldGetType(World, X, Y) == EMPTY) {
+                    TileQueueAdd(&World->Frontier, (point){X, Y});
+                }
+            }
+        }
+    }
+    
+    return World->Frontier.Length;
+}
+
+// Left click on a tile
+
+void WorldReveal(world* World, int X, int Y) {
+    
+    if(!World->Playing) return;
+    
+    if(*WorldCell(World, X, Y) & CELL_FLAGGED) return;
+    
+    // The first pick is always safe, so chunks made by earlier flags are
+    // refilled without bombs around it
+    
+    if(!World->Picked) {
+        World->Picked = 1;
+        World->FirstPick = (point){X, Y};
+        for(int Slot = 0; Slot < World->SlotCount; ++Slot) {
+            if(World->Slots[Slot]) {
+                WorldFillChunk(World, World->Slots[Slot]);
+            }
+        }
+    }
+    
+    int Type = WorldGetType(World, X, Y);
+    
+    if(!WorldVisit(World, X, Y)) return;
+    
+    if(Type == EMPTY) {
+        TileQueueAdd(&World->Frontier, (point){X, Y});
+        WorldFlood(World, WORLD_FLOOD_BUDGET);
+    } else if(Type == BOMB) {
+        
+        // Show the bombs of every chunk made so far
+        
+        World->Playing = 0;
+        *WorldCell(World, X, Y) |= CELL_HIT;
+        for(int Slot = 0; Slot < World->SlotCount; ++Slot) {
+            if(World->Slots[Slot]) {
+                unsigned char* Cells = World->Slots[Slot]->Cells;
+                for(int Index = 0; Index < CHUNK_SIZE * CHUNK_SIZE; ++Index) {
+                    if(Cells[Index] & CELL_BOMB) {
+                        Cells[Index] |= CELL_REVEALED;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Reveals the hidden neighbors of a number whose bombs are all flagged,
+// see BoardChord. The empty ones share one flood.
+
+void WorldChord(world* World, int X, int Y) {
+    
+    if(!World->Playing) return;
+    
+    unsigned char Center = *WorldCell(World, X, Y);
+    if(!(Center & CELL_REVEALED) || WorldGetType(World, X, Y) != NUMBER) return;
+    
+    int Flagged = 0;
+    for(int NY = Y - 1; NY <= Y + 1; ++NY) {
+        for(int NX = X - 1; NX <= X + 1; ++NX) {
+            Flagged += (*WorldCell(World, NX, NY) & CELL_FLAGGED) != 0;
+        }
+    }
+    
+    if(Flagged != (Center & CELL_COUNT)) return;
+    
+    for(int NY = Y - 1; NY <= Y + 1; ++NY) {
+        for(int NX = X - 1; NX <= X + 1; ++NX) {
+            unsigned char Cell = *WorldCell(World, NX, NY);
+            if(!(Cell & (CELL_REVEALED | CELL_FLAGGED)) && (Cell & CELL_BOMB)) {
+                WorldReveal(World, NX, NY);
+                return;
+            }
+        }
+    }
+    
+    for(int NY = Y - 1; NY <= Y + 1; ++NY) {
+        for(int NX = X - 1; NX <= X + 1; ++NX) {
+            if(!(*WorldCell(World, NX, NY) & CELL_FLAGGED) && WorldVisit(World, NX, NY) && WorldGetType(World, NX, NY) == EMPTY) {
+                TileQueueAdd(&World->Frontier, (point){NX, NY});
+            }
+        }
+    }
+    
+    WorldFlood(World, WORLD_FLOOD_BUDGET);
+}
+
+// Right click on a tile. Flags are not limited, the world has no bomb count.
+
+void WorldFlag(world* World, int X, int Y) {
+    
+    if(!World->Playing) return;
+    
+    unsigned char* Cell = WorldCell(World, X, Y);
+    
+    if(*Cell & CELL_FLAGGED) {
+        *Cell &= ~CELL_FLAGGED;
+        --World->Flags;
+    } else if(!(*Cell & CELL_REVEALED)) {
+        *Cell |= CELL_FLAGGED;
+        ++World->Flags;
+    }
+}